@@ -22,22 +22,47 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include <limits.h>
 
+#include "inc/hw_adc.h"
 #include "inc/hw_memmap.h"
 #include "driverlib/adc.h"
 #include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
 
 #include "altitude.h"
-#include "circBufT.h"
+#include "aux_adc.h"
+#include "calibration.h"
+#include "config.h"
+#include "filter.h"
 #include "kernel.h"
-#include "mutex.h"
+#include "moving_average.h"
+#include "settling.h"
+#include "spsc_ring.h"
 #include "utils.h"
+#include "vehicle_state.h"
+
+#if ALT_ADC_DMA && !ALT_ADC_TIMER_TRIGGER
+#error "ALT_ADC_DMA needs ALT_ADC_TIMER_TRIGGER"
+#endif
+
+#if ALT_ADC_DMA && ALT_ADC_AUX_CHANNELS
+#error "ALT_ADC_AUX_CHANNELS can't be used with ALT_ADC_DMA"
+#endif
 
 /**
  * The size of the buffer used to store the raw ADC values. This needs to be big enough that outliers in the data cannot affect the calculated mean in an adverse way.
+ * When the ADC averages its own samples the buffer is shortened to match, so the mean still covers the same 16 conversions.
+ * With the uDMA the mean is taken over each block instead.
+ * The mean costs the same whatever the size, but a power of 2 saves a division.
  */
-static const int ALT_BUF_SIZE = 16;
+#if ALT_ADC_DMA
+#define ALT_BUF_SIZE ALT_ADC_DMA_BLOCK_SIZE
+#elif ALT_ADC_TIMER_TRIGGER
+#define ALT_BUF_SIZE (16 / ALT_ADC_OVERSAMPLE)
+#else
+#define ALT_BUF_SIZE 16
+#endif
 
 /**
  * We are using ADC0 so we set up the base and peripheral
@@ -46,11 +71,72 @@ static const int ADC_BASE = ADC0_BASE;
 static const uint32_t ADC_PERIPH = SYSCTL_PERIPH_ADC0;
 
 /**
- * We want sequence 3, step 0 of ADC0
+ * We want sequence 3, step 0 of ADC0. With the auxiliary channels we want
+ * sequence 1 instead, which has room for 4 steps. The altitude is step 0
+ * and the auxiliary channels follow it.
  */
+#if ALT_ADC_AUX_CHANNELS
+static const int ADC_SEQUENCE = 1;
+#define ALT_ADC_STEPS (1 + AUX_CHANNEL_COUNT)
+#else
 static const int ADC_SEQUENCE = 3;
+#define ALT_ADC_STEPS 1
+#endif
 static const int ADC_STEP = 0;
 
+#if ALT_ADC_TIMER_TRIGGER
+/**
+ * Timer 2 triggers the ADC. Timer 1 is used by the OLED library and Timer 0
+ * by the tickless kernel.
+ */
+static const uint32_t ALT_TIMER_PERIPH = SYSCTL_PERIPH_TIMER2;
+static const uint32_t ALT_TIMER_BASE = TIMER2_BASE;
+#endif
+
+#if ALT_ADC_DMA
+/**
+ * The uDMA channel that takes the samples from sequence 3 of ADC0.
+ */
+static const uint32_t ALT_DMA_CHANNEL = UDMA_CHANNEL_ADC3;
+
+/**
+ * The uDMA channel control table. It must be aligned to 1 KiB and has room
+ * for the primary and alternate structures of every channel.
+ */
+#if defined(__TI_COMPILER_VERSION__)
+#pragma DATA_ALIGN(g_dma_control_table, 1024)
+static tDMAControlTable g_dma_control_table[64];
+#else
+static tDMAControlTable g_dma_control_table[64] __attribute__((aligned(1024)));
+#endif
+
+/**
+ * The two blocks that the uDMA fills in turn. While one is being filled the
+ * other can be read by alt_update.
+ */
+static uint16_t g_dma_blocks[2][ALT_ADC_DMA_BLOCK_SIZE];
+
+/**
+ * Whether each block has been filled and handed to alt_update, which sets
+ * it up to be filled again once it has read it. The block that the uDMA
+ * fills next and the number of times it stopped because alt_update still
+ * had both blocks.
+ */
+static volatile bool g_dma_held[2];
+static volatile uint8_t g_dma_next;
+static uint32_t g_dma_stalls;
+
+/**
+ * The number of values that the ADC interrupt can get ahead of alt_update by.
+ * With the uDMA the values are the numbers of the blocks that have been
+ * filled. Otherwise they are the raw samples, and there is room for 125 ms of
+ * them in case a long task holds up alt_update.
+ */
+#define ALT_RING_SIZE 2
+#else
+#define ALT_RING_SIZE 64
+#endif
+
 /**
  * The ideal resolution delta for a helicopter rig. This value may change depending on which helicopter rig is used. The ideal value is calculated as follows:
  * 
@@ -59,40 +145,96 @@ static const int ADC_STEP = 0;
  * Because we are using a 12-bit ADC, that the maximum value we can read from the ADC is 2^12 - 1 (4095). The Tiva board uses 3.3 V as its supply voltage, so a resolution of 4095 corresponds to 3.3 V.
  * 
  * Hence the difference in 0.8 V corresponds to 4095 * 0.8 / 3.3 (993).
+ *
+ * This is only used until the rig's own delta has been measured with alt_calibrate_full_height.
  */
 static const int ALT_DELTA = 993;
 
 /**
- * The size of the settling buffer.
+ * The smallest delta that alt_calibrate_full_height will accept. Anything less means the helicopter wasn't really at full height.
  */
-static const int ALT_SETTLING_BUF_SIZE = 10;
+static const int ALT_MIN_DELTA = 500;
+
+/**
+ * The number of percentage values in the settling window.
+ */
+#define ALT_SETTLING_BUF_SIZE 10
 
 /**
  * The maximum difference between the minimum and maximum values (as a percentage)
- * of the settling buffer for the alt_is_settled() to return true.
+ * of the settling window for the alt_is_settled() to return true.
  */
 static const int ALT_SETTLING_MARGIN = 2;
 
 /**
- * The circular buffer used to store the raw ADC values for calculating the mean.
+ * The state of each kind of filter stage. The moving average is taken over
+ * the last ALT_BUF_SIZE raw ADC values.
+ */
+static MovingAverage g_alt_average;
+static uint32_t g_alt_samples[ALT_BUF_SIZE];
+static FilterIir g_alt_iir;
+static FilterMedian g_alt_median;
+static FilterKalman g_alt_kalman;
+
+/**
+ * The chain of filter stages that each raw ADC value goes through.
+ */
+static const FilterStage g_alt_filter[] = {
+#if ALT_FILTER == ALT_FILTER_IIR
+    { "iir", filter_iir_process, &g_alt_iir },
+#elif ALT_FILTER == ALT_FILTER_MEDIAN_BOX
+    { "median", filter_median_process, &g_alt_median },
+    { "average", filter_average_process, &g_alt_average },
+#elif ALT_FILTER == ALT_FILTER_KALMAN
+    { "kalman", filter_kalman_process, &g_alt_kalman },
+#else
+    { "average", filter_average_process, &g_alt_average },
+#endif
+};
+
+static const uint8_t ALT_FILTER_STAGES = sizeof(g_alt_filter) / sizeof(FilterStage);
+
+/**
+ * The rate of climb is fitted to the last ALT_RATE_WINDOW raw ADC values
+ * (before the filter, which would only add lag).
+ */
+static FilterSlope g_alt_slope;
+static uint16_t g_alt_slope_samples[ALT_RATE_WINDOW];
+
+/**
+ * Passes what the ADC interrupt produces to alt_update, which runs the
+ * filter chain.
  */
-static circBuf_t g_circ_buffer;
+static SpscRing g_alt_ring;
+static volatile uint32_t g_alt_ring_items[ALT_RING_SIZE];
 
 /**
- * The mutex for the circular buffer.
+ * The latest output of the filter chain.
  */
-static Mutex g_circ_buffer_mutex;
+static int32_t g_alt_filtered;
 
 /**
- * The circular buffer used to store ALT_SETTLING_BUF_SIZE percentage values.
+ * The settling window over the last ALT_SETTLING_BUF_SIZE percentage values.
  */
-static circBuf_t g_settling_buffer;
+static Settling g_settling;
+static SettlingEntry g_settling_entries[2 * ALT_SETTLING_BUF_SIZE];
 
 /**
  * The reference altitude. This is updated when calling the alt_calibrate function. This is required for calculating the altitude as a percentage.
  */
 static uint16_t g_alt_ref;
 
+/**
+ * The fall in the raw ADC value from landed to full height for this rig.
+ */
+static uint16_t g_alt_delta;
+
+/**
+ * The calibration stored in the EEPROM, and whether there is one. The stored reference is restored on landing, rather than waiting to measure it again.
+ */
+static Calibration g_calibration;
+static bool g_has_stored_calibration = false;
+
 /**
  * The mean altitude. This is updated when the `void alt_update()` function is called.
  */
@@ -103,51 +245,166 @@ static uint32_t g_alt_raw;
  */
 static int16_t g_alt_percent;
 
+/**
+ * The rate of change of the altitude in tenths of a percent per second. This is updated when the `void alt_update()` function is called.
+ */
+static int16_t g_alt_rate;
+
 /**
  * Indicates if the altitude has been calibrated yet. This is set when calling the `void alt_calibrate()` function and returned when calling the `bool alt_getIsCalibrated()` function.
  */
 static bool g_has_been_calibrated = false;
 
 /**
- * Stores the frequency of the kernel task. We need this to determine if the buffer is full.
+ * The number of samples passed through the filter (up to ALT_BUF_SIZE). We need this to determine if the buffer is full.
  */
-static uint16_t g_kernel_task_frequency = USHRT_MAX;
+static uint16_t g_sample_count = 0;
 
 /**
  * (Original Code by P.J. Bones)
  * The handler for the ADC conversion complete interrupt.
- * Writes to the circular buffer.
+ * Passes the sample on to alt_update, and the auxiliary samples through
+ * their filters.
  */
 void alt_adc_int_handler(void)
 {
-    uint32_t value;
+    uint32_t values[ALT_ADC_STEPS];
 
-    // Get the single sample from ADC0.  ADC_BASE is defined in
+    // Get the sample of each step from ADC0.  ADC_BASE is defined in
     // inc/hw_memmap.h
-    ADCSequenceDataGet(ADC_BASE, ADC_SEQUENCE, &value);
+    ADCSequenceDataGet(ADC_BASE, ADC_SEQUENCE, values);
 
-    // Place it in the circular buffer (advancing write index)
-    mutex_lock(g_circ_buffer_mutex);
-    writeCircBuf(&g_circ_buffer, value);
-    mutex_unlock(g_circ_buffer_mutex);
+    // Pass it on to the filter chain. If alt_update has fallen so far
+    // behind that the ring is full, the sample is dropped.
+    spsc_ring_push(&g_alt_ring, values[0]);
+
+#if ALT_ADC_AUX_CHANNELS
+    aux_add_samples(&values[1]);
+#endif
 
     // Clean up, clearing the interrupt
     ADCIntClear(ADC_BASE, ADC_SEQUENCE);
+
+    // release the tasks waiting on a new sample
+    kernel_post_event(KERNEL_EVENT_ALT_SAMPLE);
+}
+
+#if ALT_ADC_DMA
+/**
+ * Sets up the primary (block 0) or alternate (block 1) uDMA transfer to fill
+ * a block from the sequence 3 FIFO.
+ */
+static void alt_dma_arm(uint8_t t_block)
+{
+    uint32_t select = t_block == 0 ? UDMA_PRI_SELECT : UDMA_ALT_SELECT;
+
+    uDMAChannelTransferSet(ALT_DMA_CHANNEL | select, UDMA_MODE_PINGPONG,
+                           (void*)(uintptr_t)(ADC_BASE + ADC_O_SSFIFO3), g_dma_blocks[t_block], ALT_ADC_DMA_BLOCK_SIZE);
+}
+
+/**
+ * Returns true if a block is set up to be filled and the uDMA hasn't
+ * finished it yet.
+ */
+static bool alt_dma_is_armed(uint8_t t_block)
+{
+    uint32_t select = t_block == 0 ? UDMA_PRI_SELECT : UDMA_ALT_SELECT;
+
+    return !g_dma_held[t_block] && uDMAChannelModeGet(ALT_DMA_CHANNEL | select) != UDMA_MODE_STOP;
 }
 
+/**
+ * The handler for the ADC interrupt when the uDMA takes the samples. It is
+ * raised once a block has been filled, and hands that block to alt_update.
+ * The block isn't set up again until alt_update has read it, so the uDMA
+ * can't write over it while it is being read.
+ */
+void alt_adc_block_int_handler(void)
+{
+    ADCIntClear(ADC_BASE, ADC_SEQUENCE);
+
+    // the blocks are filled in turn. both may have been filled by the time
+    // the interrupt is taken.
+    while (!g_dma_held[g_dma_next] && !alt_dma_is_armed(g_dma_next))
+    {
+        g_dma_held[g_dma_next] = true;
+        spsc_ring_push(&g_alt_ring, g_dma_next);
+        g_dma_next ^= 1;
+    }
+
+    // release the tasks waiting on a new sample
+    kernel_post_event(KERNEL_EVENT_ALT_SAMPLE);
+}
+
+/**
+ * Sets a block that alt_update has read up to be filled again. If
+ * alt_update fell a whole block behind, the uDMA will have stopped with
+ * both blocks filled, so it is started again (on block 0) once both have
+ * been read.
+ */
+static void alt_dma_release(uint8_t t_block)
+{
+    // set it up before letting the interrupt see it, so that it isn't
+    // mistaken for a filled block
+    alt_dma_arm(t_block);
+    g_dma_held[t_block] = false;
+
+    if (!uDMAChannelIsEnabled(ALT_DMA_CHANNEL) && alt_dma_is_armed(0) && alt_dma_is_armed(1))
+    {
+        g_dma_stalls++;
+        g_dma_next = 0;
+        uDMAChannelAttributeDisable(ALT_DMA_CHANNEL, UDMA_ATTR_ALTSELECT);
+        uDMAChannelEnable(ALT_DMA_CHANNEL);
+    }
+}
+
+/**
+ * Sets up the uDMA to copy the samples from sequence 3 into the two blocks
+ * in turn (ping-pong mode).
+ */
+void alt_init_dma(void)
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    uDMAEnable();
+    uDMAControlBaseSet(g_dma_control_table);
+
+    uDMAChannelAttributeDisable(ALT_DMA_CHANNEL, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(ALT_DMA_CHANNEL | UDMA_PRI_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    uDMAChannelControlSet(ALT_DMA_CHANNEL | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    alt_dma_arm(0);
+    alt_dma_arm(1);
+    uDMAChannelEnable(ALT_DMA_CHANNEL);
+
+    ADCSequenceDMAEnable(ADC_BASE, ADC_SEQUENCE);
+}
+#endif
+
 /**
  * (Original code by P.J. Bones)
  * Initialises the ADC module on the Tivaboard.
  */
 void alt_init_adc(void)
 {
+#if ALT_ADC_AUX_CHANNELS
+    uint8_t i;
+#endif
+
     // The ADC0 peripheral must be enabled for configuration and use.
     SysCtlPeripheralEnable(ADC_PERIPH);
 
+#if ALT_ADC_TIMER_TRIGGER
+    // Enable sample sequence 3 with a timer trigger.  Each time the timer
+    // times out the ADC does ALT_ADC_OVERSAMPLE conversions and averages
+    // them into a single sample, so there is only one interrupt for every
+    // ALT_ADC_OVERSAMPLE conversions.
+    ADCHardwareOversampleConfigure(ADC_BASE, ALT_ADC_OVERSAMPLE);
+    ADCSequenceConfigure(ADC_BASE, ADC_SEQUENCE, ADC_TRIGGER_TIMER, ADC_STEP);
+#else
     // Enable sample sequence 3 with a processor signal trigger.  Sequence 3
     // will do a single sample when the processor sends a signal to start the
     // conversion.
     ADCSequenceConfigure(ADC_BASE, ADC_SEQUENCE, ADC_TRIGGER_PROCESSOR, ADC_STEP);
+#endif
 
     // Configure step 0 on sequence 3.  Sample channel 0 (ADC_CTL_CH0) in
     // single-ended mode (default) and configure the interrupt flag
@@ -157,74 +414,183 @@ void alt_init_adc(void)
     // sequence 0 has 8 programmable steps.  Since we are only doing a single
     // conversion using sequence 3 we will only configure step 0.  For more
     // on the ADC sequences and steps, refer to the LM3S1968 datasheet.
+#if ALT_ADC_AUX_CHANNELS
+    // With the auxiliary channels, each trigger converts the altitude and
+    // then each auxiliary channel in turn, and the interrupt flag is only
+    // set once the last one is done.
+    ADCSequenceStepConfigure(ADC_BASE, ADC_SEQUENCE, ADC_STEP, ADC_CTL_CH9);
+    for (i = 0; i < AUX_CHANNEL_COUNT - 1; i++)
+    {
+        ADCSequenceStepConfigure(ADC_BASE, ADC_SEQUENCE, ADC_STEP + 1 + i, AUX_ADC_CHANNELS[i]);
+    }
+    ADCSequenceStepConfigure(ADC_BASE, ADC_SEQUENCE, ADC_STEP + 1 + i, AUX_ADC_CHANNELS[i] | ADC_CTL_IE | ADC_CTL_END);
+#else
     ADCSequenceStepConfigure(ADC_BASE, ADC_SEQUENCE, ADC_STEP, ADC_CTL_CH9 | ADC_CTL_IE | ADC_CTL_END);
+#endif
 
     // Since sample sequence 3 is now configured, it must be enabled.
     ADCSequenceEnable(ADC_BASE, ADC_SEQUENCE);
 
     // Register the interrupt handler
+#if ALT_ADC_DMA
+    ADCIntRegister(ADC_BASE, ADC_SEQUENCE, alt_adc_block_int_handler);
+#else
     ADCIntRegister(ADC_BASE, ADC_SEQUENCE, alt_adc_int_handler);
+#endif
 
     // Enable interrupts for ADC0 sequence 3 (clears any outstanding interrupts)
     ADCIntEnable(ADC_BASE, ADC_SEQUENCE);
 }
 
+#if ALT_ADC_TIMER_TRIGGER
+/**
+ * Starts the timer that triggers the ADC ALT_ADC_TIMER_FREQUENCY times per
+ * second. The conversions then happen without any help from the processor.
+ */
+void alt_init_timer(void)
+{
+    SysCtlPeripheralEnable(ALT_TIMER_PERIPH);
+
+    TimerConfigure(ALT_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(ALT_TIMER_BASE, TIMER_A, SysCtlClockGet() / ALT_ADC_TIMER_FREQUENCY - 1);
+    TimerControlTrigger(ALT_TIMER_BASE, TIMER_A, true);
+    TimerEnable(ALT_TIMER_BASE, TIMER_A);
+}
+#endif
+
 /**
  * (Original code by P.J. Bones)
  * The interrupt handler for the for SysTick interrupt.
  */
 void alt_process_adc(KernelTask* t_task)
 {
-    if (g_kernel_task_frequency == USHRT_MAX)
-    {
-        g_kernel_task_frequency = t_task->frequency;
-    }
-
     // Initiate a conversion
     ADCProcessorTrigger(ADC_BASE, ADC_SEQUENCE);
 }
 
 void alt_init(void)
 {
+#if ALT_ADC_AUX_CHANNELS
+    // the auxiliary channels are sampled by the altitude ADC sequence
+    aux_init();
+#endif
+
     // initialise the ADC for the altitude
     alt_init_adc();
 
-    // initialise the circular buffers
-    initCircBuf(&g_circ_buffer, ALT_BUF_SIZE);
-    initCircBuf(&g_settling_buffer, ALT_SETTLING_BUF_SIZE);
+    // initialise the filter stages and the settling window
+    moving_average_init(&g_alt_average, g_alt_samples, ALT_BUF_SIZE);
+    filter_iir_init(&g_alt_iir, ALT_FILTER_IIR_SHIFT);
+    filter_median_init(&g_alt_median, ALT_FILTER_MEDIAN_SIZE);
+    filter_kalman_init(&g_alt_kalman, ALT_FILTER_KALMAN_PROCESS_NOISE, ALT_FILTER_KALMAN_MEASUREMENT_NOISE);
+    filter_slope_init(&g_alt_slope, g_alt_slope_samples, ALT_RATE_WINDOW);
+    spsc_ring_init(&g_alt_ring, g_alt_ring_items, ALT_RING_SIZE);
+    settling_init(&g_settling, g_settling_entries, ALT_SETTLING_BUF_SIZE, ALT_SETTLING_MARGIN);
+
+    // use the rig's stored calibration, if it has one, so there is no need
+    // to wait for the buffer to fill before taking off
+    g_alt_delta = ALT_DELTA;
+    calibration_init();
+    g_has_stored_calibration = calibration_load(&g_calibration);
+    if (g_has_stored_calibration)
+    {
+        g_alt_ref = g_calibration.alt_ref;
+        g_alt_delta = g_calibration.alt_delta;
+        g_has_been_calibrated = true;
+    }
+
+    // start the conversions once there is somewhere to put them
+#if ALT_ADC_DMA
+    alt_init_dma();
+#endif
+#if ALT_ADC_TIMER_TRIGGER
+    alt_init_timer();
+#endif
 }
 
 void alt_update(KernelTask* t_task)
 {
-    int32_t sum;
-    uint16_t i;
+    uint32_t value;
 
-    // add up all the values in the circular buffer
-    sum = 0;
+#if ALT_ADC_DMA
+    uint16_t i;
 
-    mutex_wait(g_circ_buffer_mutex);
-    for (i = 0; i < ALT_BUF_SIZE; i++)
+    // pass each block that the uDMA has filled through the filter and the
+    // rate of climb fit, then hand it back to be filled again. the uDMA
+    // doesn't touch a block until it has been handed back, so it won't
+    // change while we read it. the moving average is as long as a block, so
+    // a whole block is enough to work out the mean.
+    while (spsc_ring_pop(&g_alt_ring, &value))
     {
-        sum = sum + readCircBuf(&g_circ_buffer);
+        const uint16_t* block = g_dma_blocks[value];
+        for (i = 0; i < ALT_ADC_DMA_BLOCK_SIZE; i++)
+        {
+            g_alt_filtered = filter_run(g_alt_filter, ALT_FILTER_STAGES, block[i]);
+            filter_slope_add(&g_alt_slope, block[i]);
+        }
+        g_sample_count = ALT_BUF_SIZE;
+        alt_dma_release(value);
     }
+#else
+    // pass each sample that has arrived since the last update through the
+    // filter and the rate of climb fit
+    while (spsc_ring_pop(&g_alt_ring, &value))
+    {
+        g_alt_filtered = filter_run(g_alt_filter, ALT_FILTER_STAGES, value);
+        filter_slope_add(&g_alt_slope, value);
 
-    // calculate the mean of the data in the circular buffer
-    g_alt_raw = (2 * sum + ALT_BUF_SIZE) / (2 * ALT_BUF_SIZE);
+        if (g_sample_count < ALT_BUF_SIZE)
+        {
+            g_sample_count++;
+        }
+    }
+#endif
+    g_alt_raw = g_alt_filtered;
 
     // calculate the percentage mean
-    g_alt_percent = (int16_t)((((int32_t)g_alt_ref - (int32_t)g_alt_raw) * (int32_t)100) / (int32_t)ALT_DELTA);
+    g_alt_percent = (int16_t)((((int32_t)g_alt_ref - (int32_t)g_alt_raw) * (int32_t)100) / (int32_t)g_alt_delta);
+
+    // the slope in tenths of an ADC count per second. the ADC value falls as
+    // the helicopter climbs.
+    int32_t slope = filter_slope_get(&g_alt_slope, ALT_ADC_SAMPLE_FREQUENCY * 10);
+    g_alt_rate = (int16_t)(-(int64_t)slope * 100 / g_alt_delta);
+
+    vehicle_state_publish_altitude(g_alt_percent, g_alt_rate);
 }
 
 void alt_update_settling(KernelTask* t_task)
 {
-    // write the current altitude (as a percentage) to the settling buffer.
-    writeCircBuf(&g_settling_buffer, g_alt_percent);
+    // add the current altitude (as a percentage) to the settling window.
+    settling_add(&g_settling, g_alt_percent);
 }
 
 void alt_calibrate(void)
 {
     g_alt_ref = g_alt_raw;
     g_has_been_calibrated = true;
+
+    // remember it for next time
+    g_calibration.alt_ref = g_alt_ref;
+    g_calibration.alt_delta = g_alt_delta;
+    calibration_save(&g_calibration);
+    g_has_stored_calibration = true;
+}
+
+void alt_calibrate_full_height(void)
+{
+    int32_t delta = (int32_t)g_alt_ref - (int32_t)g_alt_raw;
+
+    if (!g_has_been_calibrated || delta < ALT_MIN_DELTA)
+    {
+        return;
+    }
+
+    g_alt_delta = delta;
+
+    g_calibration.alt_ref = g_alt_ref;
+    g_calibration.alt_delta = g_alt_delta;
+    calibration_save(&g_calibration);
+    g_has_stored_calibration = true;
 }
 
 int16_t alt_get(void)
@@ -232,6 +598,20 @@ int16_t alt_get(void)
     return g_alt_percent;
 }
 
+uint32_t alt_get_dma_stalls(void)
+{
+#if ALT_ADC_DMA
+    return g_dma_stalls;
+#else
+    return 0;
+#endif
+}
+
+int16_t alt_get_rate(void)
+{
+    return g_alt_rate;
+}
+
 bool alt_has_been_calibrated(void)
 {
     return g_has_been_calibrated;
@@ -239,14 +619,23 @@ bool alt_has_been_calibrated(void)
 
 bool alt_is_buffer_full(void)
 {
-    // the buffer is full if the number of ticks performed is greater than the frequency of the
-    // altitude's kernel task
-    return (kernel_get_systick_count() > g_kernel_task_frequency);
+    // the buffer is full once every slot has had a sample written to it
+    return g_sample_count >= ALT_BUF_SIZE;
 }
 
 void alt_reset_calibration_state(void)
 {
-    g_has_been_calibrated = false;
+    // go back to the stored calibration, or measure it again at the next
+    // take off if there isn't one
+    if (g_has_stored_calibration)
+    {
+        g_alt_ref = g_calibration.alt_ref;
+        g_alt_delta = g_calibration.alt_delta;
+    }
+    else
+    {
+        g_has_been_calibrated = false;
+    }
 }
 
 /**
@@ -254,7 +643,7 @@ void alt_reset_calibration_state(void)
  */
 bool alt_is_settled(void)
 {
-    return getRangeCircBuf(&g_settling_buffer) <= ALT_SETTLING_MARGIN * 2;
+    return settling_is_settled(&g_settling);
 }
 
 /**
@@ -263,7 +652,7 @@ bool alt_is_settled(void)
 int32_t alt_get_settled(void)
 {
     if (alt_is_settled()) {
-        return getSmallestCircBuf(&g_settling_buffer) + ALT_SETTLING_MARGIN;
+        return settling_get_settled(&g_settling);
     }
     return -1;
 }
@@ -273,12 +662,5 @@ int32_t alt_get_settled(void)
  */
 bool alt_is_settled_around(int32_t t_value)
 {
-    if (alt_is_settled())
-    {
-        return range(alt_get_settled(), t_value - ALT_SETTLING_MARGIN, t_value + ALT_SETTLING_MARGIN);
-    }
-    else
-    {
-        return false;
-    }
+    return settling_is_settled_around(&g_settling, t_value);
 }
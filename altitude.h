@@ -24,8 +24,75 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "config.h"
 #include "kernel.h"
 
+/**
+ * The number of conversions that the ADC averages into each sample when it
+ * is triggered by the timer (ALT_ADC_TIMER_TRIGGER). This must be a power of
+ * 2 no greater than 64.
+ */
+#define ALT_ADC_OVERSAMPLE 4
+
+#if ALT_ADC_DMA
+/**
+ * The number of samples in each of the two blocks that the uDMA fills. The
+ * altitude is updated once per block.
+ */
+#define ALT_ADC_DMA_BLOCK_SIZE 32
+
+/**
+ * The rate that the timer triggers the ADC at (in Hz). Nothing is done per
+ * sample, so this can be much faster than the interrupt driven modes.
+ */
+#define ALT_ADC_TIMER_FREQUENCY 4096
+
+/**
+ * The rate that KERNEL_EVENT_ALT_SAMPLE is posted at (in Hz).
+ */
+#define ALT_ADC_EVENT_FREQUENCY (ALT_ADC_TIMER_FREQUENCY / ALT_ADC_DMA_BLOCK_SIZE)
+#else
+/**
+ * The rate that the timer triggers the ADC at (in Hz). With the oversampling
+ * the ADC still does 512 conversions per second.
+ */
+#define ALT_ADC_TIMER_FREQUENCY (512 / ALT_ADC_OVERSAMPLE)
+
+/**
+ * The rate that KERNEL_EVENT_ALT_SAMPLE is posted at (in Hz).
+ */
+#define ALT_ADC_EVENT_FREQUENCY ALT_ADC_TIMER_FREQUENCY
+#endif
+
+/**
+ * The rate that samples reach the filter (in Hz). Without the timer, the
+ * altitude_adc task triggers each conversion.
+ */
+#if ALT_ADC_TIMER_TRIGGER
+#define ALT_ADC_SAMPLE_FREQUENCY ALT_ADC_TIMER_FREQUENCY
+#else
+#define ALT_ADC_SAMPLE_FREQUENCY 512
+#endif
+
+/**
+ * The number of samples that the rate of climb is fitted over, which is an
+ * eighth of a second's worth in every ADC mode. A longer window is less noisy
+ * but lags more.
+ */
+#define ALT_RATE_WINDOW (ALT_ADC_SAMPLE_FREQUENCY / 8)
+
+/**
+ * The settings of the altitude filter stages (see ALT_FILTER in config.h).
+ * The IIR filter moves 1 / 2^ALT_FILTER_IIR_SHIFT of the way to each sample,
+ * which smooths about as much as the 16 sample moving average. The Kalman
+ * variances are in ADC counts squared as Q24.8 (so 6400 is a noise of 5
+ * counts).
+ */
+#define ALT_FILTER_IIR_SHIFT 3
+#define ALT_FILTER_MEDIAN_SIZE 3
+#define ALT_FILTER_KALMAN_PROCESS_NOISE 90
+#define ALT_FILTER_KALMAN_MEASUREMENT_NOISE 6400
+
 /**
  * Initialises the altitude module.
  * This must be called before any other functions in the altitude module.
@@ -38,16 +105,38 @@ void alt_init(void);
 void alt_update(KernelTask* t_task);
 
 /**
- * Calibrates the altitude to the current mean value.
+ * Calibrates the altitude to the current mean value, and stores the
+ * calibration in the EEPROM so it is used from start up next time.
  * This must be called before calling `void alt_update(void)`.
  */
 void alt_calibrate(void);
 
+/**
+ * Measures the rig's full-scale delta, with the helicopter held at full
+ * height, and stores it in the EEPROM. This is ignored if the altitude
+ * hasn't been calibrated or the helicopter is clearly not at full height.
+ */
+void alt_calibrate_full_height(void);
+
 /**
  * Returns the mean altitude as a percentage (usually from 0 - 100). This value can be less than 0 or greater than 100.
  */
 int16_t alt_get(void);
 
+/**
+ * Returns the rate that the altitude is changing at, in tenths of a percent
+ * per second (positive when climbing). This is fitted to every ADC sample, so
+ * it is much less noisy than the difference between two altitudes.
+ */
+int16_t alt_get_rate(void);
+
+/**
+ * Returns the number of times the uDMA has stopped because alt_update fell
+ * a whole block behind (ALT_ADC_DMA only). The samples are lost until
+ * alt_update catches up and it is started again.
+ */
+uint32_t alt_get_dma_stalls(void);
+
 /**
  * Returns `true` if the altitude has been calibrated.
  */
@@ -60,11 +149,13 @@ bool alt_is_buffer_full(void);
 
 /**
  * Performs an ADC conversion.
+ * This isn't needed when the ADC is triggered by the timer.
  */
 void alt_process_adc(KernelTask* t_task);
 
 /**
- * Resets the calibration state of the altitude.
+ * Resets the calibration state of the altitude. If a calibration is stored,
+ * the altitude goes back to it rather than needing to be calibrated again.
  */
 void alt_reset_calibration_state(void);
 
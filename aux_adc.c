@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *
+ * aux_adc.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains the auxiliary analogue inputs, which are sampled
+ * alongside the altitude. See aux_adc.h.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/adc.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+
+#include "aux_adc.h"
+#include "filter.h"
+
+/**
+ * The pins of the auxiliary inputs (PE3 is AIN0 and PE2 is AIN1).
+ */
+static const uint32_t AUX_PERIPH = SYSCTL_PERIPH_GPIOE;
+static const uint32_t AUX_BASE = GPIO_PORTE_BASE;
+static const uint8_t AUX_PINS = GPIO_PIN_3 | GPIO_PIN_2;
+
+const uint32_t AUX_ADC_CHANNELS[AUX_CHANNEL_COUNT] = {
+    ADC_CTL_CH0,
+    ADC_CTL_CH1,
+};
+
+/**
+ * The supply is measured through a 2:1 divider, and the ADC reads 4095 at
+ * 3300 mV.
+ */
+static const uint32_t AUX_SUPPLY_DIVIDER = 2;
+static const uint32_t AUX_ADC_FULL_SCALE_MILLIVOLTS = 3300;
+static const uint32_t AUX_ADC_FULL_SCALE = 4095;
+
+/**
+ * The filter settings. The supply has a median stage to throw away the
+ * spikes from the motors, and both channels are smoothed heavily as they
+ * only change slowly.
+ */
+#define AUX_SUPPLY_MEDIAN_SIZE 3
+#define AUX_SUPPLY_IIR_SHIFT 6
+#define AUX_SPARE_IIR_SHIFT 4
+
+/**
+ * The state of each channel's filter stages.
+ */
+static FilterMedian g_supply_median;
+static FilterIir g_supply_iir;
+static FilterIir g_spare_iir;
+
+/**
+ * The chain of filter stages for each channel.
+ */
+static const FilterStage g_supply_filter[] = {
+    { "median", filter_median_process, &g_supply_median },
+    { "iir", filter_iir_process, &g_supply_iir },
+};
+
+static const FilterStage g_spare_filter[] = {
+    { "iir", filter_iir_process, &g_spare_iir },
+};
+
+/**
+ * The latest output of each channel's filter chain.
+ */
+static volatile uint16_t g_supply;
+static volatile uint16_t g_spare;
+
+void aux_init(void)
+{
+    filter_median_init(&g_supply_median, AUX_SUPPLY_MEDIAN_SIZE);
+    filter_iir_init(&g_supply_iir, AUX_SUPPLY_IIR_SHIFT);
+    filter_iir_init(&g_spare_iir, AUX_SPARE_IIR_SHIFT);
+
+    SysCtlPeripheralEnable(AUX_PERIPH);
+    GPIOPinTypeADC(AUX_BASE, AUX_PINS);
+}
+
+void aux_add_samples(const uint32_t* t_samples)
+{
+    g_supply = filter_run(g_supply_filter, sizeof(g_supply_filter) / sizeof(FilterStage), t_samples[0]);
+    g_spare = filter_run(g_spare_filter, sizeof(g_spare_filter) / sizeof(FilterStage), t_samples[1]);
+}
+
+uint16_t aux_get_supply_millivolts(void)
+{
+    return g_supply * AUX_SUPPLY_DIVIDER * AUX_ADC_FULL_SCALE_MILLIVOLTS / AUX_ADC_FULL_SCALE;
+}
+
+uint16_t aux_get_spare(void)
+{
+    return g_spare;
+}
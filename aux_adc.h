@@ -0,0 +1,65 @@
+/*******************************************************************************
+ *
+ * aux_adc.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains the auxiliary analogue inputs, which are sampled by
+ * the same ADC sequence and trigger as the altitude (ALT_ADC_AUX_CHANNELS).
+ * They cost an extra conversion each per trigger, but no more interrupts or
+ * kernel tasks. Each channel has its own filter chain, which is run by the
+ * altitude ADC interrupt.
+ *
+ * The channels are:
+ *  - the supply voltage, through a 2:1 divider on PE3 (AIN0)
+ *  - a spare input on PE2 (AIN1)
+ *
+ ******************************************************************************/
+
+#ifndef AUX_ADC_H_
+#define AUX_ADC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The number of auxiliary channels. The altitude sequence converts these
+ * after the altitude, in the order of AUX_ADC_CHANNELS.
+ */
+#define AUX_CHANNEL_COUNT 2
+
+/**
+ * The ADC step settings (ADC_CTL_CHx) of each channel.
+ */
+extern const uint32_t AUX_ADC_CHANNELS[AUX_CHANNEL_COUNT];
+
+/**
+ * Initialises the auxiliary input pins and filters.
+ * This must be called before the altitude ADC is started.
+ */
+void aux_init(void);
+
+/**
+ * Passes one raw sample of each channel (in the order of AUX_ADC_CHANNELS)
+ * through its filter. This is called by the altitude ADC interrupt.
+ */
+void aux_add_samples(const uint32_t* t_samples);
+
+/**
+ * Returns the supply voltage in millivolts.
+ */
+uint16_t aux_get_supply_millivolts(void);
+
+/**
+ * Returns the filtered spare input as a raw ADC value (0 - 4095).
+ */
+uint16_t aux_get_spare(void);
+
+#endif /* AUX_ADC_H_ */
@@ -0,0 +1,54 @@
+/*******************************************************************************
+ *
+ * barrier.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains the memory barriers used to share data between ISRs
+ * and tasks without locking.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+#include "barrier.h"
+
+uint32_t barrier_load_acquire(const volatile uint32_t* t_value)
+{
+#if defined(__TI_COMPILER_VERSION__)
+    // 32 bit loads are atomic on the Cortex-M4, and the shared data is
+    // volatile so the compiler keeps it in order. the barrier keeps the
+    // processor from doing otherwise.
+    uint32_t value = *t_value;
+    __asm("    dmb");
+    return value;
+#else
+    return __atomic_load_n(t_value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void barrier_store_release(volatile uint32_t* t_value, uint32_t t_new_value)
+{
+#if defined(__TI_COMPILER_VERSION__)
+    __asm("    dmb");
+    *t_value = t_new_value;
+#else
+    __atomic_store_n(t_value, t_new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+void barrier_fence(void)
+{
+#if defined(__TI_COMPILER_VERSION__)
+    __asm("    dmb");
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ *
+ * barrier.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains the memory barriers used to share data between ISRs
+ * and tasks without locking (see spsc_ring.h and seqlock.h). On the
+ * Cortex-M4 they are a dmb instruction, and on the host they are the
+ * compiler's atomics, so the same code can be stress tested on two threads.
+ *
+ ******************************************************************************/
+
+#ifndef BARRIER_H_
+#define BARRIER_H_
+
+#include <stdint.h>
+
+/**
+ * Reads a 32 bit value that another context writes. Nothing after this can
+ * be moved before it.
+ */
+uint32_t barrier_load_acquire(const volatile uint32_t* t_value);
+
+/**
+ * Writes a 32 bit value that another context reads. Nothing before this can
+ * be moved after it.
+ */
+void barrier_store_release(volatile uint32_t* t_value, uint32_t t_new_value);
+
+/**
+ * Stops any memory access from being moved across it in either direction.
+ */
+void barrier_fence(void);
+
+#endif /* BARRIER_H_ */
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ *
+ * calibration.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module keeps the calibration of a helicopter rig in the on-chip
+ * EEPROM. See calibration.h.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "driverlib/eeprom.h"
+#include "driverlib/sysctl.h"
+
+#include "calibration.h"
+
+/**
+ * The version of the record layout. This must be changed whenever the
+ * Calibration struct is, so that old records are ignored.
+ */
+static const uint32_t CALIBRATION_VERSION = 1;
+
+/**
+ * Marks the record as ours (it spells "HELI").
+ */
+static const uint32_t CALIBRATION_MAGIC = 0x494C4548;
+
+/**
+ * The address of the record in the EEPROM.
+ */
+static const uint32_t CALIBRATION_ADDRESS = 0;
+
+/**
+ * The record as it is stored. The EEPROM is read and written in whole
+ * words, so every field is a word.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t alt_ref;
+    uint32_t alt_delta;
+    uint32_t crc;
+} CalibrationRecord;
+
+#define CALIBRATION_RECORD_WORDS (sizeof(CalibrationRecord) / sizeof(uint32_t))
+
+/**
+ * Whether the EEPROM started up properly. If it didn't, nothing is read from
+ * or written to it.
+ */
+static bool g_eeprom_ok = false;
+
+/**
+ * Returns the CRC-32 (as used by zip) of the record's fields before the CRC.
+ * It is worked out a bit at a time, as it is only needed at start up and
+ * when the calibration changes.
+ */
+static uint32_t calibration_crc(const CalibrationRecord* t_record)
+{
+    const uint32_t* words = (const uint32_t*)t_record;
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t i;
+    uint8_t bit;
+
+    for (i = 0; i < CALIBRATION_RECORD_WORDS - 1; i++)
+    {
+        crc ^= words[i];
+        for (bit = 0; bit < 32; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+void calibration_init(void)
+{
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_EEPROM0);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_EEPROM0))
+    {
+        continue;
+    }
+
+    g_eeprom_ok = EEPROMInit() == EEPROM_INIT_OK;
+}
+
+bool calibration_load(Calibration* t_calibration)
+{
+    CalibrationRecord record;
+
+    if (!g_eeprom_ok)
+    {
+        return false;
+    }
+
+    EEPROMRead((uint32_t*)&record, CALIBRATION_ADDRESS, sizeof(record));
+
+    if (record.magic != CALIBRATION_MAGIC || record.version != CALIBRATION_VERSION ||
+        record.crc != calibration_crc(&record))
+    {
+        return false;
+    }
+
+    t_calibration->alt_ref = record.alt_ref;
+    t_calibration->alt_delta = record.alt_delta;
+    return true;
+}
+
+void calibration_save(const Calibration* t_calibration)
+{
+    Calibration stored;
+    CalibrationRecord record;
+
+    // the EEPROM wears out, so don't write the same thing again
+    if (!g_eeprom_ok || (calibration_load(&stored) && stored.alt_ref == t_calibration->alt_ref &&
+                         stored.alt_delta == t_calibration->alt_delta))
+    {
+        return;
+    }
+
+    record.magic = CALIBRATION_MAGIC;
+    record.version = CALIBRATION_VERSION;
+    record.alt_ref = t_calibration->alt_ref;
+    record.alt_delta = t_calibration->alt_delta;
+    record.crc = calibration_crc(&record);
+
+    EEPROMProgram((uint32_t*)&record, CALIBRATION_ADDRESS, sizeof(record));
+}
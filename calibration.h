@@ -0,0 +1,55 @@
+/*******************************************************************************
+ *
+ * calibration.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module keeps the calibration of a helicopter rig in the on-chip
+ * EEPROM, so it only has to be measured once. The record carries a version
+ * and a CRC, and is ignored if either doesn't match (such as on a new board,
+ * or after the record's layout changes).
+ *
+ ******************************************************************************/
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The calibration of a rig.
+ */
+typedef struct {
+    // the raw ADC value when landed
+    uint16_t alt_ref;
+
+    // the fall in the raw ADC value from landed to full height
+    uint16_t alt_delta;
+} Calibration;
+
+/**
+ * Initialises the EEPROM.
+ * This must be called before any other functions in the calibration module.
+ */
+void calibration_init(void);
+
+/**
+ * Reads the stored calibration into t_calibration.
+ * Returns false (leaving t_calibration alone) if nothing valid is stored.
+ */
+bool calibration_load(Calibration* t_calibration);
+
+/**
+ * Stores the calibration, if it differs from what is stored already.
+ */
+void calibration_save(const Calibration* t_calibration);
+
+#endif /* CALIBRATION_H_ */
@@ -22,6 +22,11 @@
 #ifndef CLOCK_H_
 #define CLOCK_H_
 
+/**
+ * The rate of the system clock set up by clock_init (in Hz).
+ */
+#define CLOCK_RATE 40000000
+
 void clock_init(void);
 
 #endif
@@ -10,6 +10,13 @@
 
 #include <stdbool.h>
 
+// set to true when building for the host computer rather than the Tiva board.
+// this swaps the parts that only exist on the board (such as the DWT cycle
+// counter) for deterministic stand-ins.
+#ifndef CONFIG_HOST_BUILD
+#define CONFIG_HOST_BUILD false
+#endif
+
 // set to true if we want to purposefully introduce long-running tasks
 // to the kernel. this will mess it up.
 #define SATURATE_KERNEL false
@@ -17,6 +24,51 @@
 // set to true if we want to send kernel timing data down the UART
 #define DUMP_KERNEL_DATA false
 
+// set to true to run the kernel from a free-running timer that wakes the
+// processor when the next task is due, rather than a 400 kHz SysTick interrupt.
+#define KERNEL_TICKLESS false
+
+// set to true to stagger the first release of each periodic task so that
+// tasks don't all come due on the same tick.
+#define KERNEL_PHASE_OFFSETS true
+
+// set to true to have a timer trigger the altitude ADC with hardware
+// averaging, rather than a kernel task triggering every conversion.
+#define ALT_ADC_TIMER_TRIGGER false
+
+// set to true to have the uDMA collect the timer triggered altitude samples
+// into blocks, with one interrupt per block (needs ALT_ADC_TIMER_TRIGGER).
+#define ALT_ADC_DMA false
+
+// set to true to sample the auxiliary analogue inputs (see aux_adc.h) with
+// the altitude, using a multi-step ADC sequence on the same trigger. this
+// can't be used with ALT_ADC_DMA.
+#define ALT_ADC_AUX_CHANNELS false
+
+// set to true to count the yaw encoder with the QEI peripheral rather than
+// take an interrupt on every edge. the encoder has to be wired to the QEI0
+// pins (PD6 for channel A and PD7 for channel B) rather than PB0 and PB1.
+#ifndef YAW_QEI
+#define YAW_QEI false
+#endif
+
+// the filter chain that the altitude samples go through:
+//  - ALT_FILTER_BOX: a moving average (16 samples at 512 Hz)
+//  - ALT_FILTER_IIR: a single pole low pass filter
+//  - ALT_FILTER_MEDIAN_BOX: a 3 sample median to remove spikes, then the
+//    moving average
+//  - ALT_FILTER_KALMAN: a 1-D Kalman estimator
+// host/bench/filter_bench.c compares their cost, noise and lag on an ADC trace.
+#define ALT_FILTER_BOX 0
+#define ALT_FILTER_IIR 1
+#define ALT_FILTER_MEDIAN_BOX 2
+#define ALT_FILTER_KALMAN 3
+#define ALT_FILTER ALT_FILTER_BOX
+
+// the number of empty tasks to add to the kernel. used with DUMP_KERNEL_DATA
+// to measure how the scheduler overhead scales with the number of tasks.
+#define KERNEL_BENCHMARK_TASKS 0
+
 // set to true if we want to directly control the duty cycle of the helirig
 // and turn off the control systems.
 #define CONFIG_DIRECT_CONTROL false
@@ -28,6 +28,7 @@
 #include "pwm.h"
 #include "flight_mode.h"
 #include "utils.h"
+#include "vehicle_state.h"
 
 struct control_state_s
 {
@@ -37,8 +38,7 @@ struct control_state_s
   float kp;
   float ki;
   float kd;
-  int16_t lastError;
-  int16_t cumulative;
+  int32_t cumulative;
   uint8_t duty;
 };
 
@@ -69,6 +69,9 @@ static const uint8_t TAIL_GAIN_CLAMP = 10;
 static const uint8_t INTEGRAL_TAIL_CLAMP = 30;
 static const uint8_t INTEGRAL_MAIN_CLAMP = 5;
 
+// Half a turn of yaw (centidegrees)
+static const int32_t YAW_HALF_TURN = 180 * YAW_CENTIDEGREES_PER_DEGREE;
+
 static ControlState g_control_altitude;
 static ControlState g_control_yaw;
 
@@ -84,7 +87,6 @@ ControlState control_get_state_from_gains(ControlGains t_gains)
         t_gains.kp, // Kp
         t_gains.ki, // Ki
         t_gains.kd, // Kd
-        0, // lastError
         0, // cumulative error
         0}; // current duty% of motor
 }
@@ -109,9 +111,12 @@ void control_update_altitude(KernelTask* t_task)
     float Dgain = 0;
     int16_t newDuty = 0;
 
+    // the altitude and its rate from the same update
+    VehicleState state;
+    vehicle_state_get(&state);
 
     // the difference between what we want and what we have (as a percentage)
-    int16_t error = setpoint_get_altitude() - alt_get();
+    int16_t error = setpoint_get_altitude() - state.altitude;
 
     // P control, clamped to 10%
     Pgain = error*g_control_altitude.kp;
@@ -125,8 +130,11 @@ void control_update_altitude(KernelTask* t_task)
     Igain = g_control_altitude.cumulative * g_control_altitude.ki;
 
     // D control, clamped to 10%
-    Dgain = (error - g_control_altitude.lastError)*g_control_altitude.kd;
-    g_control_altitude.lastError = error;
+    // uses the measured rate of climb rather than the change in error, which
+    // is much less noisy and doesn't kick when the setpoint changes. it is
+    // scaled to the change in altitude per control period (the rate is in
+    // tenths of a percent per second) so the gain means the same as before.
+    Dgain = -state.altitude_rate * g_control_altitude.kd / (10.0f * t_task->frequency);
     Dgain = clamp(Dgain, -MAIN_GAIN_CLAMP, MAIN_GAIN_CLAMP);
 
     // Calculate new motor duty percentage gain
@@ -154,42 +162,36 @@ void control_update_yaw(KernelTask* t_task)
     float Pgain = 0;
     float Igain = 0;
     float Dgain = 0;
-    bool clockWise = true;
     int16_t newDuty = 0;
 
-    // the difference between what we want and what we have (in degrees)
-    int16_t error = (setpoint_get_yaw() - yaw_get());
+    VehicleState state;
+    vehicle_state_get(&state);
 
-    // negative error implies set point is behind us (CCW direction)
-    if (error < 0) {
-        clockWise = false;
-        error = abs(error);
-    }
-    // An error over 180 will always be further than going in the opposite direction
-    if (error > 180) {
-        error = (360 - error);
-        // flip whatever direction we were going in originally
-        clockWise = !clockWise;
-    }
-    // C-CW movement requires subtracting duty, so we need a negative error.
-    if (!clockWise) {
-        error = -error;
-    }
+    // the difference between what we want and what we have (in centidegrees,
+    // so the yaw is held to finer than a degree)
+    int32_t error = (int32_t)setpoint_get_yaw() * YAW_CENTIDEGREES_PER_DEGREE - state.yaw_centidegrees;
+
+    // take the shorter way round, so the error is from -180 up to 180 degrees
+    // (negative is C-CW, which requires subtracting duty). the error is more
+    // than -360 degrees, so adding one and a half turns keeps it positive
+    error = (error + 3 * YAW_HALF_TURN) % (2 * YAW_HALF_TURN) - YAW_HALF_TURN;
 
-    // P control with +- 10% clamp
-    Pgain = error*g_control_yaw.kp;
+    // P control with +- 10% clamp. the gains are per degree of error
+    Pgain = error*g_control_yaw.kp / YAW_CENTIDEGREES_PER_DEGREE;
     Pgain = clamp(Pgain, -TAIL_GAIN_CLAMP, TAIL_GAIN_CLAMP);
 
     // I control, only accumulate error if we are not motor duty limited (limits overshoot)
     if (g_control_yaw.duty > MIN_TAIL_DUTY && g_control_yaw.duty < MAX_TAIL_DUTY)
     {
-        g_control_yaw.cumulative += clamp(error, -INTEGRAL_TAIL_CLAMP, INTEGRAL_TAIL_CLAMP);; // Clamp integral growth for large errors
+        // Clamp integral growth for large errors
+        g_control_yaw.cumulative += clamp(error, -INTEGRAL_TAIL_CLAMP * YAW_CENTIDEGREES_PER_DEGREE, INTEGRAL_TAIL_CLAMP * YAW_CENTIDEGREES_PER_DEGREE);
     }
-    Igain = g_control_yaw.cumulative*g_control_yaw.ki;
+    Igain = g_control_yaw.cumulative*g_control_yaw.ki / YAW_CENTIDEGREES_PER_DEGREE;
 
-    // D control with +- 10% clamp
-    Dgain = (error - g_control_yaw.lastError)*g_control_yaw.kd; // Control is called with fixed frequency so time delta can be ignored.
-    g_control_yaw.lastError = error;
+    // D control with +- 10% clamp. the error changes by the opposite of the
+    // yaw, so the measured rate of turn (in tenths of a degree per second) is
+    // scaled to the change in error per call to keep the same gain
+    Dgain = -(state.yaw_rate / 10.0f / t_task->frequency)*g_control_yaw.kd;
     Dgain = clamp(Dgain, -TAIL_GAIN_CLAMP, TAIL_GAIN_CLAMP);
 
     // Calculate new motor duty percentage gain
@@ -213,7 +215,6 @@ void control_enable_yaw(bool t_enabled)
     {
         g_control_yaw.cumulative = 0;
         g_control_yaw.duty = 0;
-        g_control_yaw.lastError = 0;
         pwm_set_tail_duty(0);
     }
     else
@@ -229,7 +230,6 @@ void control_enable_altitude(bool t_enabled)
     {
         g_control_altitude.cumulative = 0;
         g_control_altitude.duty = 0;
-        g_control_altitude.lastError = 0;
         pwm_set_main_duty(0);
     }
     else
@@ -0,0 +1,219 @@
+/*******************************************************************************
+ *
+ * filter.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains filter stages that can be chained together to clean
+ * up a stream of samples. Every stage uses fixed-point arithmetic. A chain
+ * is an array of FilterStages, each of which passes its output on to the
+ * next one.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "filter.h"
+#include "moving_average.h"
+
+/**
+ * The number of fractional bits in the Q16.16 values.
+ */
+static const uint8_t FILTER_Q = 16;
+
+/**
+ * Rounds a Q16.16 value to the nearest whole number.
+ */
+static int32_t filter_round(int32_t t_value)
+{
+    return (t_value + (1 << (FILTER_Q - 1))) >> FILTER_Q;
+}
+
+int32_t filter_run(const FilterStage* t_stages, uint8_t t_count, int32_t t_sample)
+{
+    uint8_t i;
+    for (i = 0; i < t_count; i++)
+    {
+        t_sample = t_stages[i].process(t_stages[i].state, t_sample);
+    }
+    return t_sample;
+}
+
+int32_t filter_average_process(void* t_state, int32_t t_sample)
+{
+    MovingAverage* average = t_state;
+
+    moving_average_add(average, (uint32_t)t_sample);
+    return (int32_t)moving_average_get(average);
+}
+
+void filter_iir_init(FilterIir* t_filter, uint8_t t_shift)
+{
+    t_filter->value = 0;
+    t_filter->shift = t_shift;
+    t_filter->primed = false;
+}
+
+int32_t filter_iir_process(void* t_state, int32_t t_sample)
+{
+    FilterIir* filter = t_state;
+    int32_t sample = t_sample << FILTER_Q;
+
+    // start from the first sample rather than ramping up from zero
+    if (!filter->primed)
+    {
+        filter->value = sample;
+        filter->primed = true;
+    }
+
+    filter->value += (sample - filter->value) >> filter->shift;
+    return filter_round(filter->value);
+}
+
+void filter_median_init(FilterMedian* t_filter, uint8_t t_size)
+{
+    t_filter->size = t_size > FILTER_MEDIAN_MAX_SIZE ? FILTER_MEDIAN_MAX_SIZE : t_size;
+    t_filter->index = 0;
+    t_filter->primed = false;
+}
+
+int32_t filter_median_process(void* t_state, int32_t t_sample)
+{
+    FilterMedian* filter = t_state;
+    int32_t sorted[FILTER_MEDIAN_MAX_SIZE];
+    uint8_t i;
+
+    // fill the window with the first sample so the output starts there
+    if (!filter->primed)
+    {
+        for (i = 0; i < filter->size; i++)
+        {
+            filter->samples[i] = t_sample;
+        }
+        filter->primed = true;
+    }
+
+    filter->samples[filter->index] = t_sample;
+    filter->index++;
+    if (filter->index >= filter->size)
+    {
+        filter->index = 0;
+    }
+
+    // an insertion sort is quickest for a handful of samples
+    for (i = 0; i < filter->size; i++)
+    {
+        int32_t value = filter->samples[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > value)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    return sorted[filter->size / 2];
+}
+
+void filter_kalman_init(FilterKalman* t_filter, uint32_t t_process_noise, uint32_t t_measurement_noise)
+{
+    t_filter->estimate = 0;
+    t_filter->process_noise = t_process_noise;
+    t_filter->measurement_noise = t_measurement_noise;
+
+    // we know the first sample only as well as the measurement noise allows
+    t_filter->error = t_measurement_noise;
+    t_filter->primed = false;
+}
+
+int32_t filter_kalman_process(void* t_state, int32_t t_sample)
+{
+    FilterKalman* filter = t_state;
+    int32_t sample = t_sample << FILTER_Q;
+
+    if (!filter->primed)
+    {
+        filter->estimate = sample;
+        filter->primed = true;
+        return t_sample;
+    }
+
+    // predict: the value stays put, but we become less sure of it
+    uint32_t predicted_error = filter->error + filter->process_noise;
+
+    // update: the gain (Q16.16) weighs the sample against the prediction
+    uint32_t gain = (predicted_error << FILTER_Q) / (predicted_error + filter->measurement_noise);
+    filter->estimate += (int32_t)(((int64_t)gain * (sample - filter->estimate)) >> FILTER_Q);
+    filter->error = (((1u << FILTER_Q) - gain) * predicted_error) >> FILTER_Q;
+
+    // the error can round down to nothing, which would stop the estimate
+    // from ever moving again
+    if (filter->error == 0)
+    {
+        filter->error = 1;
+    }
+
+    return filter_round(filter->estimate);
+}
+
+void filter_slope_init(FilterSlope* t_filter, uint16_t* t_samples, uint16_t t_size)
+{
+    t_filter->samples = t_samples;
+    t_filter->size = t_size;
+    t_filter->index = 0;
+    t_filter->sum = 0;
+    t_filter->weighted_sum = 0;
+    t_filter->primed = false;
+}
+
+void filter_slope_add(FilterSlope* t_filter, int32_t t_sample)
+{
+    uint16_t i;
+
+    // start from a flat line through the first sample rather than a ramp up
+    // from zero
+    if (!t_filter->primed)
+    {
+        for (i = 0; i < t_filter->size; i++)
+        {
+            t_filter->samples[i] = t_sample;
+        }
+        t_filter->sum = t_sample * t_filter->size;
+        t_filter->weighted_sum = (int64_t)t_sample * t_filter->size * (t_filter->size - 1) / 2;
+        t_filter->primed = true;
+    }
+
+    // every sample gets one period older, so the weighted sum drops by the
+    // sum of the samples that stay. the oldest sample counted 0 times anyway.
+    int32_t oldest = t_filter->samples[t_filter->index];
+    t_filter->weighted_sum += (int64_t)t_sample * (t_filter->size - 1) - (t_filter->sum - oldest);
+    t_filter->sum += t_sample - oldest;
+
+    t_filter->samples[t_filter->index] = t_sample;
+    t_filter->index++;
+    if (t_filter->index >= t_filter->size)
+    {
+        t_filter->index = 0;
+    }
+}
+
+int32_t filter_slope_get(const FilterSlope* t_filter, int32_t t_scale)
+{
+    int64_t size = t_filter->size;
+
+    // the least-squares slope over ages 0 to n - 1 is
+    // (12 * sum(age * x) - 6 * (n - 1) * sum(x)) / (n * (n^2 - 1))
+    int64_t numerator = 12 * t_filter->weighted_sum - 6 * (size - 1) * t_filter->sum;
+    int64_t denominator = size * (size * size - 1);
+
+    return (int32_t)(numerator * t_scale / denominator);
+}
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ *
+ * filter.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains filter stages that can be chained together to clean
+ * up a stream of samples. Every stage uses fixed-point arithmetic. A chain
+ * is an array of FilterStages, each of which passes its output on to the
+ * next one.
+ *
+ ******************************************************************************/
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "moving_average.h"
+
+/**
+ * The most samples that a median stage can take the median of.
+ */
+#define FILTER_MEDIAN_MAX_SIZE 9
+
+/**
+ * A stage of a filter chain. The function takes the stage's state and a
+ * sample, and returns the filtered sample.
+ */
+typedef struct {
+    const char* name;
+    int32_t (*process)(void* t_state, int32_t t_sample);
+    void* state;
+} FilterStage;
+
+/**
+ * A single pole low pass (exponential moving average) filter. Each sample
+ * moves the output 1 / 2^shift of the way towards it. The output is kept in
+ * Q16.16 so that small steps aren't lost.
+ */
+typedef struct {
+    int32_t value;
+    uint8_t shift;
+    bool primed;
+} FilterIir;
+
+/**
+ * Takes the median of the last `size` samples (an odd number up to
+ * FILTER_MEDIAN_MAX_SIZE) to throw away single sample spikes.
+ */
+typedef struct {
+    int32_t samples[FILTER_MEDIAN_MAX_SIZE];
+    uint8_t size;
+    uint8_t index;
+    bool primed;
+} FilterMedian;
+
+/**
+ * A 1-D Kalman estimator for a value that wanders slowly. The estimate is
+ * kept in Q16.16, and the error and noise variances are in samples squared
+ * as Q24.8. The variances must stay below 2^16 (256 samples squared).
+ */
+typedef struct {
+    int32_t estimate;
+    uint32_t error;
+    uint32_t process_noise;
+    uint32_t measurement_noise;
+    bool primed;
+} FilterKalman;
+
+/**
+ * Estimates how fast the samples are changing with a least-squares line
+ * through the last `size` samples (at least 2). The samples are stored in an
+ * array given to filter_slope_init. The sums that the line is fitted from
+ * are kept as the samples arrive, so adding a sample and getting the slope
+ * both take the same time however wide the window is.
+ */
+typedef struct {
+    uint16_t* samples;
+    uint16_t size;
+    uint16_t index;
+
+    // the sum of the samples, and of each sample times its age (with the
+    // oldest sample counting 0 times and the newest size - 1 times)
+    int32_t sum;
+    int64_t weighted_sum;
+    bool primed;
+} FilterSlope;
+
+/**
+ * Passes a sample through each stage of a chain in turn and returns what
+ * comes out of the last one.
+ */
+int32_t filter_run(const FilterStage* t_stages, uint8_t t_count, int32_t t_sample);
+
+/**
+ * A moving average stage. The state is a MovingAverage (see
+ * moving_average.h) and the samples must not be negative.
+ */
+int32_t filter_average_process(void* t_state, int32_t t_sample);
+
+/**
+ * Initialises a single pole low pass stage that moves 1 / 2^t_shift of the
+ * way towards each sample.
+ */
+void filter_iir_init(FilterIir* t_filter, uint8_t t_shift);
+
+/**
+ * A single pole low pass stage. The state is a FilterIir.
+ */
+int32_t filter_iir_process(void* t_state, int32_t t_sample);
+
+/**
+ * Initialises a median stage over t_size samples.
+ */
+void filter_median_init(FilterMedian* t_filter, uint8_t t_size);
+
+/**
+ * A median stage. The state is a FilterMedian.
+ */
+int32_t filter_median_process(void* t_state, int32_t t_sample);
+
+/**
+ * Initialises a Kalman stage. The process noise is how much the value can
+ * be expected to wander between samples and the measurement noise is how
+ * noisy the samples are (both variances in samples squared, as Q24.8).
+ */
+void filter_kalman_init(FilterKalman* t_filter, uint32_t t_process_noise, uint32_t t_measurement_noise);
+
+/**
+ * A Kalman stage. The state is a FilterKalman.
+ */
+int32_t filter_kalman_process(void* t_state, int32_t t_sample);
+
+/**
+ * Initialises a slope estimator over the t_size samples in t_samples.
+ */
+void filter_slope_init(FilterSlope* t_filter, uint16_t* t_samples, uint16_t t_size);
+
+/**
+ * Adds a sample (from 0 to 65535) to a slope estimator, replacing the oldest
+ * one.
+ */
+void filter_slope_add(FilterSlope* t_filter, int32_t t_sample);
+
+/**
+ * Returns the slope of the line through the samples, in samples per sample
+ * period multiplied by t_scale (rounded towards zero). The slope times
+ * t_scale must fit in an int32_t.
+ */
+int32_t filter_slope_get(const FilterSlope* t_filter, int32_t t_scale);
+
+#endif /* FILTER_H_ */
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ *
+ * OrbitOLEDInterface.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for the Orbit OLED interface. Strings are drawn into a
+ * text frame that can be read back with hal_oled_get_line.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "OrbitOLED/OrbitOLEDInterface.h"
+
+#include "hal.h"
+
+/**
+ * The size of the display in 8x8 pixel characters.
+ */
+#define OLED_ROWS 4
+#define OLED_COLUMNS 16
+
+static char g_frame[OLED_ROWS][OLED_COLUMNS + 1];
+
+void OLEDInitialise(void)
+{
+    uint8_t row;
+    for (row = 0; row < OLED_ROWS; row++)
+    {
+        memset(g_frame[row], ' ', OLED_COLUMNS);
+        g_frame[row][OLED_COLUMNS] = '\0';
+    }
+}
+
+void OLEDStringDraw(const char *pcStr, uint32_t ulColumn, uint32_t ulRow)
+{
+    if (ulRow >= OLED_ROWS)
+    {
+        return;
+    }
+
+    // anything past the edge of the display is lost
+    while (*pcStr && ulColumn < OLED_COLUMNS)
+    {
+        g_frame[ulRow][ulColumn++] = *pcStr++;
+    }
+}
+
+const char* hal_oled_get_line(uint8_t t_row)
+{
+    return t_row < OLED_ROWS ? g_frame[t_row] : "";
+}
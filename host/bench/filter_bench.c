@@ -0,0 +1,320 @@
+/*******************************************************************************
+ *
+ * filter_bench.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Compares altitude filter chains on a trace of raw ADC samples, so that we
+ * can pick the cheapest one that is quiet enough.
+ *
+ * Usage: filter-bench [adc trace]
+ *
+ * The trace has one raw ADC sample per line, taken at 512 Hz. Without one a
+ * trace is made up from a few steps, a slow wave, noise and the odd spike.
+ *
+ * The noise in the trace is taken to be whatever a centred (so lag free)
+ * running median leaves behind. For each chain this prints:
+ *  - the time taken per sample of the trace, in host processor cycles where
+ *    the host has a cycle counter (otherwise nanoseconds)
+ *  - the lag, which is how long the output takes to get half way through a
+ *    clean step
+ *  - the noise, which is the RMS of the output when the chain is given only
+ *    the noise from the trace
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNITS "cycles"
+#else
+#define BENCH_UNITS "ns"
+#endif
+
+#include "altitude.h"
+#include "filter.h"
+#include "moving_average.h"
+
+/**
+ * The rate the samples were taken at (in Hz).
+ */
+static const double BENCH_SAMPLE_RATE = 512.0;
+
+/**
+ * The number of samples either side of the centred running median that the
+ * noise is measured against.
+ */
+#define BENCH_MEDIAN_HALF_WIDTH 16
+
+/**
+ * The number of samples the chains are given to settle before their output
+ * is looked at.
+ */
+#define BENCH_SETTLE_SAMPLES 256
+
+/**
+ * The level that the noise is added to, and the size of the step used to
+ * measure the lag (in ADC counts).
+ */
+static const int32_t BENCH_LEVEL = 2048;
+static const int32_t BENCH_STEP = 400;
+
+/**
+ * The number of samples made up when no trace is given.
+ */
+static const uint32_t BENCH_SYNTHETIC_SAMPLES = 20000;
+
+/**
+ * The most stages in a chain.
+ */
+#define BENCH_MAX_STAGES 3
+
+typedef struct {
+    const char* name;
+    uint8_t stage_count;
+    FilterStage stages[BENCH_MAX_STAGES];
+} BenchChain;
+
+// the state of every stage used by the chains
+static MovingAverage g_box16;
+static uint32_t g_box16_samples[16];
+static MovingAverage g_box32;
+static uint32_t g_box32_samples[32];
+static MovingAverage g_box64;
+static uint32_t g_box64_samples[64];
+static FilterIir g_iir3;
+static FilterIir g_iir4;
+static FilterMedian g_median3;
+static FilterMedian g_median5;
+static FilterKalman g_kalman;
+
+/**
+ * The chains to compare. The first four are the ALT_FILTER choices.
+ */
+static const BenchChain g_chains[] = {
+    { "box 16 (ALT_FILTER_BOX)", 1, { { "average", filter_average_process, &g_box16 } } },
+    { "iir (ALT_FILTER_IIR)", 1, { { "iir", filter_iir_process, &g_iir3 } } },
+    { "median 3 + box 16 (ALT_FILTER_MEDIAN_BOX)", 2, {
+        { "median", filter_median_process, &g_median3 },
+        { "average", filter_average_process, &g_box16 } } },
+    { "kalman (ALT_FILTER_KALMAN)", 1, { { "kalman", filter_kalman_process, &g_kalman } } },
+    { "box 32", 1, { { "average", filter_average_process, &g_box32 } } },
+    { "box 64", 1, { { "average", filter_average_process, &g_box64 } } },
+    { "iir shift 4", 1, { { "iir", filter_iir_process, &g_iir4 } } },
+    { "median 5 + box 16", 2, {
+        { "median", filter_median_process, &g_median5 },
+        { "average", filter_average_process, &g_box16 } } },
+    { "median 3 + kalman", 2, {
+        { "median", filter_median_process, &g_median3 },
+        { "kalman", filter_kalman_process, &g_kalman } } },
+};
+
+/**
+ * Puts every stage back to its starting state.
+ */
+static void bench_reset(void)
+{
+    moving_average_init(&g_box16, g_box16_samples, 16);
+    moving_average_init(&g_box32, g_box32_samples, 32);
+    moving_average_init(&g_box64, g_box64_samples, 64);
+    filter_iir_init(&g_iir3, ALT_FILTER_IIR_SHIFT);
+    filter_iir_init(&g_iir4, 4);
+    filter_median_init(&g_median3, ALT_FILTER_MEDIAN_SIZE);
+    filter_median_init(&g_median5, 5);
+    filter_kalman_init(&g_kalman, ALT_FILTER_KALMAN_PROCESS_NOISE, ALT_FILTER_KALMAN_MEASUREMENT_NOISE);
+}
+
+/**
+ * Returns a timestamp in BENCH_UNITS.
+ */
+static uint64_t bench_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+/**
+ * Runs a chain over some samples and returns the time it took.
+ */
+static uint64_t bench_run(const BenchChain* t_chain, const int32_t* t_samples, int32_t* t_output, uint32_t t_count)
+{
+    uint32_t i;
+
+    bench_reset();
+    uint64_t start = bench_now();
+    for (i = 0; i < t_count; i++)
+    {
+        t_output[i] = filter_run(t_chain->stages, t_chain->stage_count, t_samples[i]);
+    }
+    return bench_now() - start;
+}
+
+static int bench_compare(const void* t_a, const void* t_b)
+{
+    return *(const int32_t*)t_a - *(const int32_t*)t_b;
+}
+
+/**
+ * Makes up a trace: a few steps, a slow wave, noise and the odd spike.
+ */
+static int32_t* bench_synthesise(uint32_t* t_count)
+{
+    int32_t* samples = malloc(BENCH_SYNTHETIC_SAMPLES * sizeof(int32_t));
+    uint32_t seed = 1;
+    uint32_t i;
+
+    for (i = 0; i < BENCH_SYNTHETIC_SAMPLES; i++)
+    {
+        double value = 2500 - 200 * ((i / 4000) % 3) + 40 * sin(i / 200.0);
+
+        // roughly normal noise with a standard deviation of 5 counts
+        double noise = 0;
+        uint8_t j;
+        for (j = 0; j < 12; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            noise += (seed >> 16 & 0x7FFF) / 32768.0;
+        }
+        value += (noise - 6) * 5;
+
+        // and a spike every so often
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16 & 0xFF) == 0)
+        {
+            value += 300;
+        }
+
+        samples[i] = (int32_t)value;
+    }
+
+    *t_count = BENCH_SYNTHETIC_SAMPLES;
+    return samples;
+}
+
+/**
+ * Reads a trace of raw ADC samples.
+ */
+static int32_t* bench_read(const char* t_filename, uint32_t* t_count)
+{
+    FILE* file = fopen(t_filename, "r");
+    uint32_t capacity = 1024;
+    int32_t* samples;
+    int value;
+
+    if (file == NULL)
+    {
+        perror(t_filename);
+        exit(EXIT_FAILURE);
+    }
+
+    samples = malloc(capacity * sizeof(int32_t));
+    *t_count = 0;
+    while (fscanf(file, "%d", &value) == 1)
+    {
+        if (*t_count == capacity)
+        {
+            capacity *= 2;
+            samples = realloc(samples, capacity * sizeof(int32_t));
+        }
+        samples[(*t_count)++] = value;
+    }
+
+    fclose(file);
+    return samples;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count;
+    int32_t* samples = argc > 1 ? bench_read(argv[1], &count) : bench_synthesise(&count);
+    uint32_t half = BENCH_MEDIAN_HALF_WIDTH;
+    uint32_t noise_count = count - 2 * half;
+    uint32_t step_count = 2 * BENCH_SETTLE_SAMPLES;
+    int32_t* output = malloc(count * sizeof(int32_t));
+    int32_t* noise = malloc(count * sizeof(int32_t));
+    int32_t step[2 * BENCH_SETTLE_SAMPLES];
+    double sum = 0;
+    uint32_t i;
+    uint8_t c;
+
+    if (count <= 2 * half + BENCH_SETTLE_SAMPLES)
+    {
+        fprintf(stderr, "the trace is too short\n");
+        return EXIT_FAILURE;
+    }
+
+    // the noise is what is left once the centred running median is taken
+    // away. the median keeps the steps and throws out the spikes, so the
+    // spikes count as noise.
+    for (i = 0; i < noise_count; i++)
+    {
+        int32_t window[2 * BENCH_MEDIAN_HALF_WIDTH + 1];
+        memcpy(window, &samples[i], sizeof(window));
+        qsort(window, 2 * half + 1, sizeof(int32_t), bench_compare);
+
+        noise[i] = BENCH_LEVEL + samples[i + half] - window[half];
+        sum += (double)(samples[i + half] - window[half]) * (samples[i + half] - window[half]);
+    }
+
+    // a clean step, after giving the chain time to settle
+    for (i = 0; i < step_count; i++)
+    {
+        step[i] = BENCH_LEVEL + (i < BENCH_SETTLE_SAMPLES ? 0 : BENCH_STEP);
+    }
+
+    printf("%u samples at %.0f Hz, %.2f counts of noise (RMS)\n\n", count, BENCH_SAMPLE_RATE, sqrt(sum / noise_count));
+    printf("%-44s %14s %12s %12s\n", "Chain", BENCH_UNITS "/sample", "Lag (ms)", "Noise (RMS)");
+
+    for (c = 0; c < sizeof(g_chains) / sizeof(BenchChain); c++)
+    {
+        const BenchChain* chain = &g_chains[c];
+
+        // the cost on the real samples
+        uint64_t elapsed = bench_run(chain, samples, output, count);
+
+        // the noise that gets through
+        bench_run(chain, noise, output, noise_count);
+        sum = 0;
+        for (i = BENCH_SETTLE_SAMPLES; i < noise_count; i++)
+        {
+            sum += (double)(output[i] - BENCH_LEVEL) * (output[i] - BENCH_LEVEL);
+        }
+        double noise_out = sqrt(sum / (noise_count - BENCH_SETTLE_SAMPLES));
+
+        // the time taken to get half way through the step
+        bench_run(chain, step, output, step_count);
+        i = BENCH_SETTLE_SAMPLES;
+        while (i < step_count && output[i] < BENCH_LEVEL + BENCH_STEP / 2)
+        {
+            i++;
+        }
+        double lag = (i - BENCH_SETTLE_SAMPLES) * 1000.0 / BENCH_SAMPLE_RATE;
+
+        printf("%-44s %14.1f %12.1f %12.2f\n", chain->name, (double)elapsed / count, lag, noise_out);
+    }
+
+    free(samples);
+    free(output);
+    free(noise);
+
+    return EXIT_SUCCESS;
+}
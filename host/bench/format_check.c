@@ -0,0 +1,83 @@
+/*******************************************************************************
+ *
+ * format_check.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Checks that the host build formats the UART and display strings the way
+ * the 32-bit target does, in particular that negative values come out
+ * negative rather than as huge unsigned numbers.
+ *
+ * Usage: format-check
+ *
+ * Each case is formatted with usnprintf (or usprintf) and compared with the
+ * string that the target sends.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/ustdlib.h"
+
+/**
+ * The size of the buffer that each case is formatted into, the same as the
+ * UART's.
+ */
+#define CHECK_BUFFER_SIZE 64
+
+static uint32_t g_failures;
+
+static void check_string(const char* t_got, const char* t_expected)
+{
+    bool passed = strcmp(t_got, t_expected) == 0;
+    printf("%-24s %-24s%s\n", t_got, t_expected, passed ? "" : " FAILED");
+    if (!passed)
+    {
+        g_failures++;
+    }
+}
+
+int main(void)
+{
+    char buffer[CHECK_BUFFER_SIZE];
+    int16_t altitude = -251;
+    int16_t rate = INT16_MIN;
+    int32_t total_yaw = -1440;
+    uint16_t yaw = 359;
+    int8_t duty = -5;
+
+    printf("%-24s %-24s\n", "formatted", "expected");
+
+    usnprintf(buffer, sizeof(buffer), "a%d", altitude);
+    check_string(buffer, "a-251");
+
+    usnprintf(buffer, sizeof(buffer), "r%d\tw%d", rate, -1);
+    check_string(buffer, "r-32768\tw-1");
+
+    usnprintf(buffer, sizeof(buffer), "y%u\tn%d", yaw, total_yaw);
+    check_string(buffer, "y359\tn-1440");
+
+    usnprintf(buffer, sizeof(buffer), "Main Duty: %4d%%", duty);
+    check_string(buffer, "Main Duty:   -5%");
+
+    usprintf(buffer, "%s,%u,%d", "task", 4000000000u, -7);
+    check_string(buffer, "task,4000000000,-7");
+
+    // longer than the buffer, so it is cut short
+    usnprintf(buffer, 8, "a%d\tr%d", altitude, rate);
+    check_string(buffer, "a-251\tr");
+
+    printf("%s\n", g_failures == 0 ? "passed" : "FAILED");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
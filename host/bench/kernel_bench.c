@@ -0,0 +1,171 @@
+/*******************************************************************************
+ *
+ * kernel_bench.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Measures how the cost of the scheduler grows with the number of tasks. For
+ * each table size it builds a table of that many empty tasks, runs the
+ * kernel over the same stretch of simulated time and prints the cost of
+ * kernel_run per pass that ran tasks, per task run and per pass that found
+ * nothing to do.
+ *
+ * Usage: kernel-bench [seconds]
+ *
+ * The firmware's own table leaves little room for the benchmark tasks that
+ * main.c can add (KERNEL_BENCHMARK_TASKS), so this is built with
+ * KERNEL_MAX_TASKS raised to 32. The tasks are spread over a few rates, like
+ * the firmware's, so the release queue has work to do. The costs are in host
+ * processor cycles where the host has a cycle counter (otherwise
+ * nanoseconds), so they are only good for comparing the sizes with each
+ * other.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNITS "cycles"
+#else
+#define BENCH_UNITS "ns"
+#endif
+
+#include "driverlib/sysctl.h"
+
+#include "hal.h"
+#include "kernel.h"
+
+/**
+ * The number of simulated seconds to run each table for if none is given.
+ */
+static const uint32_t BENCH_SECONDS = 2;
+
+/**
+ * The number of cycles simulated between calls to kernel_run, which is one
+ * tick of the periodic kernel (as in host_main.c).
+ */
+static const uint32_t BENCH_PASS_CYCLES = 100;
+
+/**
+ * The table sizes to measure.
+ */
+static const uint8_t BENCH_SIZES[] = { 1, 2, 4, 8, 12, 16, 24, 32 };
+#define BENCH_SIZE_COUNT (sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]))
+
+// the number of times the tasks have run
+static uint32_t g_runs;
+
+static void bench_task(KernelTask* t_task)
+{
+    g_runs++;
+}
+
+/**
+ * The tasks that the tables are built from, in turn. All of them are at the
+ * same priority, so any order of them is a valid table.
+ */
+static const KernelTask BENCH_TEMPLATES[] = {
+    KERNEL_TASK(bench_512, bench_task, 512, KERNEL_SHED_PRIORITY, 10)
+    KERNEL_TASK(bench_100, bench_task, 100, KERNEL_SHED_PRIORITY, 10)
+    KERNEL_TASK(bench_30, bench_task, 30, KERNEL_SHED_PRIORITY, 10)
+    KERNEL_TASK(bench_10, bench_task, 10, KERNEL_SHED_PRIORITY, 10)
+};
+#define BENCH_TEMPLATE_COUNT (sizeof(BENCH_TEMPLATES) / sizeof(BENCH_TEMPLATES[0]))
+
+static KernelTask g_tasks[KERNEL_MAX_TASKS];
+
+/**
+ * Returns a timestamp in BENCH_UNITS.
+ */
+static uint64_t bench_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+/**
+ * The time spent in kernel_run over a run of the benchmark, split between
+ * the passes that ran tasks and those that didn't.
+ */
+typedef struct {
+    uint64_t busy_time;
+    uint32_t busy_passes;
+    uint64_t idle_time;
+    uint32_t idle_passes;
+} BenchResult;
+
+/**
+ * Runs a table of t_size tasks for t_passes passes of BENCH_PASS_CYCLES.
+ */
+static BenchResult bench_run(uint8_t t_size, uint32_t t_passes)
+{
+    BenchResult result = { 0, 0, 0, 0 };
+    uint32_t i;
+
+    for (i = 0; i < t_size; i++)
+    {
+        g_tasks[i] = BENCH_TEMPLATES[i % BENCH_TEMPLATE_COUNT];
+    }
+    kernel_init(g_tasks, t_size);
+    g_runs = 0;
+
+    for (i = 0; i < t_passes; i++)
+    {
+        uint32_t runs = g_runs;
+        uint64_t start = bench_now();
+        kernel_run();
+        uint64_t time = bench_now() - start;
+
+        if (g_runs != runs)
+        {
+            result.busy_time += time;
+            result.busy_passes++;
+        }
+        else
+        {
+            result.idle_time += time;
+            result.idle_passes++;
+        }
+
+        hal_advance(BENCH_PASS_CYCLES);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : BENCH_SECONDS;
+    uint32_t passes = (uint64_t)seconds * SysCtlClockGet() / BENCH_PASS_CYCLES;
+    uint8_t i;
+
+    printf("%u passes per table (%u s), in %s\n", passes, seconds, BENCH_UNITS);
+    printf("tasks  task runs  busy passes  per busy pass  per task run  per idle pass\n");
+
+    for (i = 0; i < BENCH_SIZE_COUNT && BENCH_SIZES[i] <= KERNEL_MAX_TASKS; i++)
+    {
+        BenchResult result = bench_run(BENCH_SIZES[i], passes);
+        printf("%5u  %9u  %11u  %13.1f  %12.1f  %13.1f\n", BENCH_SIZES[i], g_runs, result.busy_passes,
+               (double)result.busy_time / result.busy_passes, (double)result.busy_time / g_runs,
+               (double)result.idle_time / result.idle_passes);
+    }
+
+    return EXIT_SUCCESS;
+}
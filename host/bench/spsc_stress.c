@@ -0,0 +1,170 @@
+/*******************************************************************************
+ *
+ * spsc_stress.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Runs a producer and a consumer of a SpscRing on two threads as fast as
+ * they can go, to check that no value is ever lost, repeated, reordered or
+ * torn when the two sides really do run at the same time.
+ *
+ * Usage: spsc-stress [values] [ring size]
+ *
+ * Two runs are made:
+ *  - lossless, where the producer retries until each value fits, so the
+ *    consumer must see every value in order
+ *  - lossy, where the producer drops a value if the ring is full (as the ADC
+ *    interrupt does), so the consumer must see values in increasing order and
+ *    the values seen and dropped must add up to the values pushed
+ *
+ * Each value is its own sequence number, so a slot read before it was
+ * written shows up as an old value out of order.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "spsc_ring.h"
+
+/**
+ * The defaults for the number of values to pass through and the size of the
+ * ring. A small ring keeps the two sides tripping over each other.
+ */
+static const uint32_t STRESS_VALUES = 50000000;
+static const uint32_t STRESS_RING_SIZE = 16;
+
+typedef struct {
+    SpscRing ring;
+    uint32_t count;
+    bool lossless;
+
+    // filled in by the producer, before any retries of the last value
+    uint32_t dropped;
+
+    // filled in by the consumer
+    uint32_t received;
+    uint32_t errors;
+} StressRun;
+
+static void* stress_produce(void* t_run)
+{
+    StressRun* run = t_run;
+    uint32_t i;
+
+    for (i = 0; i < run->count; i++)
+    {
+        // on a single core the consumer can't make room until it is given
+        // a turn
+        while (!spsc_ring_push(&run->ring, i) && run->lossless)
+        {
+            sched_yield();
+        }
+    }
+
+    run->dropped = spsc_ring_get_dropped(&run->ring);
+
+    // the last value tells the consumer that there are no more coming
+    while (!spsc_ring_push(&run->ring, UINT32_MAX))
+    {
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void* stress_consume(void* t_run)
+{
+    StressRun* run = t_run;
+    uint32_t expected = 0;
+    uint32_t value;
+
+    while (true)
+    {
+        if (!spsc_ring_pop(&run->ring, &value))
+        {
+            sched_yield();
+            continue;
+        }
+        if (value == UINT32_MAX)
+        {
+            break;
+        }
+
+        // the values that were dropped are skipped over. anything else out of
+        // sequence is an error.
+        if (run->lossless ? value != expected : value < expected)
+        {
+            run->errors++;
+        }
+        expected = value + 1;
+        run->received++;
+    }
+    return NULL;
+}
+
+/**
+ * Pushes t_count values through a ring of t_size on two threads, and
+ * returns true if the consumer saw what it should have.
+ */
+static bool stress_run(uint32_t t_count, uint32_t t_size, bool t_lossless)
+{
+    uint32_t* items = malloc(t_size * sizeof(uint32_t));
+    StressRun run = { .count = t_count, .lossless = t_lossless };
+    pthread_t producer;
+    pthread_t consumer;
+    struct timespec start;
+    struct timespec end;
+
+    spsc_ring_init(&run.ring, items, t_size);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&consumer, NULL, stress_consume, &run);
+    pthread_create(&producer, NULL, stress_produce, &run);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    uint32_t dropped = run.dropped;
+
+    // a lossless producer counts every retry as a drop, so only the lossy
+    // run can be checked against the drop count
+    bool passed = run.errors == 0 &&
+        (t_lossless ? run.received == t_count : run.received + dropped == t_count);
+
+    printf("%-8s %10u pushed %10u received %10u dropped %6u errors %8.1f M/s  %s\n",
+           t_lossless ? "lossless" : "lossy", t_count, run.received, t_lossless ? 0 : dropped,
+           run.errors, t_count / seconds / 1e6, passed ? "ok" : "FAILED");
+
+    free(items);
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : STRESS_VALUES;
+    uint32_t size = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : STRESS_RING_SIZE;
+
+    if (size == 0 || (size & (size - 1)) != 0)
+    {
+        fprintf(stderr, "the ring size must be a power of 2\n");
+        return EXIT_FAILURE;
+    }
+
+    bool passed = stress_run(count, size, true);
+    passed = stress_run(count, size, false) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
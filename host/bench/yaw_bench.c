@@ -0,0 +1,268 @@
+/*******************************************************************************
+ *
+ * yaw_bench.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Measures the cost of decoding each yaw encoder edge, which the yaw
+ * interrupt does thousands of times a second when the helicopter spins
+ * quickly. The transition table in yaw.c is compared with the chain of
+ * comparisons that it replaced (copied in here), on the same edges. The
+ * table's time includes recording when each edge happened for the yaw rate,
+ * which the chain didn't do.
+ *
+ * Usage: yaw-bench [edges]
+ *
+ * The edges turn the helicopter back and forth in runs of random length,
+ * with the odd repeated state and glitch (both signals changing at once).
+ * Both decoders must agree on the yaw after every edge. The time is given
+ * per edge, in host processor cycles where the host has a cycle counter
+ * (otherwise nanoseconds).
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNITS "cycles"
+#else
+#define BENCH_UNITS "ns"
+#endif
+
+#include "kernel.h"
+#include "mutex.h"
+#include "vehicle_state.h"
+#include "yaw.h"
+
+/**
+ * The default number of edges to decode.
+ */
+static const uint32_t BENCH_EDGES = 10000000;
+
+/**
+ * The number of times each decoder is run over the edges. The fastest run
+ * is reported.
+ */
+static const uint8_t BENCH_RUNS = 5;
+
+/**
+ * 112 teeth over 4 phases.
+ */
+static const int BENCH_MAX_SLOT_COUNT = 448;
+
+// defined in yaw.c
+void yaw_update_state(bool t_signal_a, bool t_signal_b);
+
+/*******************************************************************************
+ * The decoder that yaw.c used before the transition table
+ ******************************************************************************/
+
+enum bench_quadrature_state { BENCH_CLOCKWISE, BENCH_ANTICLOCKWISE, BENCH_NOCHANGE, BENCH_INVALID };
+
+static uint8_t g_previous_state;
+static volatile uint8_t g_quadrature_state;
+static Mutex g_quadrature_state_mutex;
+static volatile uint16_t g_slot_count;
+static Mutex g_slot_count_mutex;
+
+static void bench_chain_update_state(bool t_signal_a, bool t_signal_b)
+{
+    mutex_lock(g_slot_count_mutex);
+    mutex_lock(g_quadrature_state_mutex);
+
+    uint8_t this_state = (t_signal_a << 1) | t_signal_b;
+
+    if (this_state == g_previous_state) {
+        g_quadrature_state = BENCH_NOCHANGE;
+    } else {
+        if (
+                (this_state == 0 && g_previous_state == 1) ||
+                (this_state == 1 && g_previous_state == 3) ||
+                (this_state == 2 && g_previous_state == 0) ||
+                (this_state == 3 && g_previous_state == 2)) {
+
+            g_quadrature_state = BENCH_ANTICLOCKWISE;
+
+            if (--g_slot_count > BENCH_MAX_SLOT_COUNT - 1) {
+                g_slot_count = BENCH_MAX_SLOT_COUNT - 1;
+            }
+
+        } else {
+            if (
+                    (this_state == 0 && g_previous_state == 2) ||
+                    (this_state == 1 && g_previous_state == 0) ||
+                    (this_state == 2 && g_previous_state == 3) ||
+                    (this_state == 3 && g_previous_state == 1)) {
+
+                g_quadrature_state = BENCH_CLOCKWISE;
+
+                if (++g_slot_count > BENCH_MAX_SLOT_COUNT - 1) {
+                    g_slot_count = 0;
+                }
+            } else {
+                g_quadrature_state = BENCH_INVALID;
+            }
+        }
+    }
+
+    g_previous_state = this_state;
+
+    if (g_quadrature_state == BENCH_CLOCKWISE || g_quadrature_state == BENCH_ANTICLOCKWISE)
+    {
+        // it didn't count whole turns
+        vehicle_state_publish_yaw((uint32_t)g_slot_count * 36000 / BENCH_MAX_SLOT_COUNT, 0);
+    }
+
+    mutex_unlock(g_quadrature_state_mutex);
+    mutex_unlock(g_slot_count_mutex);
+}
+
+static uint16_t bench_chain_get(void)
+{
+    return (uint32_t)g_slot_count * 360 / BENCH_MAX_SLOT_COUNT;
+}
+
+/*******************************************************************************
+ * The benchmark
+ ******************************************************************************/
+
+/**
+ * Returns a timestamp in BENCH_UNITS.
+ */
+static uint64_t bench_now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+/**
+ * Fills t_states with the signal states ((A << 1) | B) seen at each edge.
+ */
+static void bench_make_edges(uint8_t* t_states, uint32_t t_count)
+{
+    // the signals go 0, 1, 3, 2 when turning clockwise
+    static const uint8_t GRAY[4] = { 0, 1, 3, 2 };
+    uint8_t phase = 0;
+    bool clockwise = true;
+    uint32_t run = 0;
+    uint32_t i;
+
+    srand(361);
+    for (i = 0; i < t_count; i++)
+    {
+        if (run == 0)
+        {
+            clockwise = !clockwise;
+            run = 1 + rand() % 2000;
+        }
+        run--;
+
+        int r = rand() % 1000;
+        if (r == 0)
+        {
+            // a glitch: both signals change at once
+            t_states[i] = GRAY[phase] ^ 3;
+            continue;
+        }
+        if (r == 1)
+        {
+            // the same state again
+            t_states[i] = GRAY[phase];
+            continue;
+        }
+
+        phase = (phase + (clockwise ? 1 : 3)) & 3;
+        t_states[i] = GRAY[phase];
+    }
+}
+
+/**
+ * Runs a decoder over the edges and returns the time it took.
+ */
+static uint64_t bench_run(void (*t_update)(bool, bool), const uint8_t* t_states, uint32_t t_count)
+{
+    uint32_t i;
+    uint64_t start = bench_now();
+
+    for (i = 0; i < t_count; i++)
+    {
+        t_update(t_states[i] & 2, t_states[i] & 1);
+    }
+
+    return bench_now() - start;
+}
+
+/**
+ * Returns the fastest of BENCH_RUNS runs of a decoder over the edges.
+ */
+static uint64_t bench_best(void (*t_update)(bool, bool), const uint8_t* t_states, uint32_t t_count)
+{
+    uint64_t best = UINT64_MAX;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_RUNS; i++)
+    {
+        uint64_t time = bench_run(t_update, t_states, t_count);
+        if (time < best)
+        {
+            best = time;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : BENCH_EDGES;
+    uint8_t* states = malloc(count);
+    uint32_t mismatches = 0;
+    uint32_t i;
+
+    if (states == NULL)
+    {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+    bench_make_edges(states, count);
+
+    // the yaw interrupt times the edges with the kernel's clock
+    kernel_set_clock(&KERNEL_CLOCK_VIRTUAL);
+
+    // the two decoders must agree on every edge
+    for (i = 0; i < count; i++)
+    {
+        yaw_update_state(states[i] & 2, states[i] & 1);
+        bench_chain_update_state(states[i] & 2, states[i] & 1);
+        if (yaw_get() != bench_chain_get())
+        {
+            mismatches++;
+        }
+    }
+
+    uint64_t chain = bench_best(bench_chain_update_state, states, count);
+    uint64_t table = bench_best(yaw_update_state, states, count);
+
+    printf("%u edges, %u mismatches\n", count, mismatches);
+    printf("comparison chain  %6.2f %s/edge\n", (double)chain / count, BENCH_UNITS);
+    printf("transition table  %6.2f %s/edge\n", (double)table / count, BENCH_UNITS);
+
+    free(states);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,263 @@
+/*******************************************************************************
+ *
+ * yaw_check.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Turns the simulated yaw encoder back and forth and checks that yaw.c
+ * follows it. It is built once for each yaw backend (the edge interrupts and,
+ * with YAW_QEI set, the QEI), which must both pass.
+ *
+ * Usage: yaw-check
+ *
+ * The encoder is turned before the reference is found (which mustn't move
+ * the yaw), then through several turns each way after it. yaw_get(),
+ * yaw_get_centidegrees() and yaw_get_position() are checked after every edge.
+ * The whole turns and the yaw in the vehicle state are checked after each run
+ * of edges, once the backend has had time to publish them.
+ *
+ * The encoder is then turned at steady rates, with yaw_update_rate run 100
+ * times a second as the kernel would, and the rate of turn is checked once
+ * it has settled and again once the encoder has stopped.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+
+#include "config.h"
+#include "hal.h"
+#include "kernel.h"
+#include "vehicle_state.h"
+#include "yaw.h"
+
+/**
+ * Where the encoder is wired for each backend.
+ */
+#if YAW_QEI
+static const uint32_t CHECK_ENCODER_PORT = GPIO_PORTD_BASE;
+static const uint8_t CHECK_ENCODER_PIN_A = GPIO_PIN_6;
+static const uint8_t CHECK_ENCODER_PIN_B = GPIO_PIN_7;
+#else
+static const uint32_t CHECK_ENCODER_PORT = GPIO_PORTB_BASE;
+static const uint8_t CHECK_ENCODER_PIN_A = GPIO_PIN_0;
+static const uint8_t CHECK_ENCODER_PIN_B = GPIO_PIN_1;
+#endif
+
+static const uint32_t CHECK_REFERENCE_PORT = GPIO_PORTC_BASE;
+static const uint8_t CHECK_REFERENCE_PIN = GPIO_PIN_4;
+
+/**
+ * 112 teeth over 4 phases.
+ */
+static const int32_t CHECK_SLOTS = 448;
+
+/**
+ * The time between edges (in processor cycles), and the time allowed after
+ * a run of edges for the yaw to be published.
+ */
+static const uint32_t CHECK_EDGE_CYCLES = 2000;
+static const uint32_t CHECK_SETTLE_CYCLES = 400000;
+
+/**
+ * The number of cycles between runs of yaw_update_rate (100 Hz at 40 MHz),
+ * and how far the rate can be from the true rate (in tenths of a percent).
+ */
+static const uint32_t CHECK_RATE_TASK_CYCLES = 400000;
+static const int32_t CHECK_RATE_TOLERANCE = 20;
+
+// the encoder's phase (0 - 3) and where the yaw should be (in slots)
+static uint8_t g_phase;
+static int32_t g_expected_slots;
+static uint32_t g_failures;
+
+static uint16_t check_centidegrees(void)
+{
+    int32_t slots = ((g_expected_slots % CHECK_SLOTS) + CHECK_SLOTS) % CHECK_SLOTS;
+    return slots * 36000 / CHECK_SLOTS;
+}
+
+static uint16_t check_degrees(void)
+{
+    return check_centidegrees() / 100;
+}
+
+static int32_t check_turns(void)
+{
+    return (g_expected_slots - (g_expected_slots < 0 ? CHECK_SLOTS - 1 : 0)) / CHECK_SLOTS;
+}
+
+/**
+ * Moves the encoder by one edge. Channel B leads channel A when turning
+ * clockwise, so (A, B) goes 00, 01, 11, 10.
+ */
+static void check_move(bool t_clockwise)
+{
+    static const uint8_t STATES[4] = { 0, 1, 3, 2 };
+
+    g_phase = (g_phase + (t_clockwise ? 1 : 3)) & 3;
+    uint8_t state = STATES[g_phase];
+    hal_gpio_set(CHECK_ENCODER_PORT, CHECK_ENCODER_PIN_A | CHECK_ENCODER_PIN_B,
+                 ((state & 2) ? CHECK_ENCODER_PIN_A : 0) | ((state & 1) ? CHECK_ENCODER_PIN_B : 0));
+}
+
+/**
+ * Moves the encoder by one edge and waits for CHECK_EDGE_CYCLES.
+ */
+static void check_step(bool t_clockwise)
+{
+    check_move(t_clockwise);
+    hal_advance(CHECK_EDGE_CYCLES);
+}
+
+/**
+ * Turns the encoder by some number of edges (clockwise if positive), checking
+ * yaw_get() after every edge if t_counting is set.
+ */
+static void check_turn(const char* t_name, int32_t t_edges, bool t_counting)
+{
+    int32_t i;
+    uint32_t failures = 0;
+    bool clockwise = t_edges > 0;
+
+    for (i = 0; i < abs(t_edges); i++)
+    {
+        check_step(clockwise);
+        if (t_counting)
+        {
+            g_expected_slots += clockwise ? 1 : -1;
+        }
+        if (yaw_get() != check_degrees() || yaw_get_centidegrees() != check_centidegrees()
+                || yaw_get_position() != g_expected_slots)
+        {
+            failures++;
+        }
+    }
+
+    hal_advance(CHECK_SETTLE_CYCLES);
+
+    VehicleState state;
+    vehicle_state_get(&state);
+    if (state.yaw != check_degrees() || state.yaw_centidegrees != check_centidegrees()
+            || state.yaw_turns != check_turns() || yaw_get_turns() != check_turns())
+    {
+        failures++;
+    }
+
+    printf("%-28s %6d edges: yaw %5u %3d turns, published %5u %3d turns, expected %5u %3d turns%s\n", t_name, t_edges,
+           yaw_get_centidegrees(), yaw_get_turns(), state.yaw_centidegrees, state.yaw_turns,
+           check_centidegrees(), check_turns(), failures == 0 ? "" : " FAILED");
+    g_failures += failures;
+}
+
+/**
+ * Pulses the reference low and high again, as the helicopter passes it.
+ */
+static void check_reference(void)
+{
+    hal_gpio_set(CHECK_REFERENCE_PORT, CHECK_REFERENCE_PIN, 0);
+    hal_advance(CHECK_EDGE_CYCLES);
+    hal_gpio_set(CHECK_REFERENCE_PORT, CHECK_REFERENCE_PIN, CHECK_REFERENCE_PIN);
+    hal_advance(CHECK_EDGE_CYCLES);
+    g_expected_slots = 0;
+}
+
+/**
+ * Turns the encoder by some number of edges (clockwise if positive) at a
+ * steady rate, then checks the rate of turn. It is checked again after the
+ * encoder has been stopped for a second.
+ */
+static void check_rate(const char* t_name, int32_t t_edges, uint32_t t_cycles_per_edge)
+{
+    int32_t i;
+    uint32_t failures = 0;
+    uint64_t next_task = hal_get_cycles() + CHECK_RATE_TASK_CYCLES;
+
+    for (i = 0; i < abs(t_edges); i++)
+    {
+        check_move(t_edges > 0);
+        g_expected_slots += t_edges > 0 ? 1 : -1;
+
+        uint64_t next_edge = hal_get_cycles() + t_cycles_per_edge;
+        while (next_task <= next_edge)
+        {
+            hal_advance(next_task - hal_get_cycles());
+            yaw_update_rate(NULL);
+            next_task += CHECK_RATE_TASK_CYCLES;
+        }
+        hal_advance(next_edge - hal_get_cycles());
+    }
+
+    // tenths of a degree per second
+    int32_t expected = (int64_t)(t_edges > 0 ? 1 : -1) * 3600 * SysCtlClockGet() / CHECK_SLOTS / t_cycles_per_edge;
+    int16_t turning = yaw_get_rate();
+    if (abs(turning - expected) * 1000 > abs(expected) * CHECK_RATE_TOLERANCE)
+    {
+        failures++;
+    }
+
+    for (i = 0; i < 100; i++)
+    {
+        hal_advance(next_task - hal_get_cycles());
+        yaw_update_rate(NULL);
+        next_task += CHECK_RATE_TASK_CYCLES;
+    }
+
+    VehicleState state;
+    vehicle_state_get(&state);
+    if (yaw_get_rate() != 0 || state.yaw_rate != 0)
+    {
+        failures++;
+    }
+
+    printf("%-28s %6d edges: rate %6d, expected %6d, stopped %d%s\n", t_name, t_edges,
+           turning, expected, state.yaw_rate, failures == 0 ? "" : " FAILED");
+    g_failures += failures;
+}
+
+int main(void)
+{
+    // the yaw interrupts time the edges with the kernel's clock
+    kernel_set_clock(&KERNEL_CLOCK_VIRTUAL);
+    vehicle_state_init();
+    yaw_init();
+
+    printf("yaw backend: %s\n", YAW_QEI ? "QEI" : "edge interrupts");
+
+    check_turn("before the reference", 300, false);
+    check_reference();
+    check_turn("at the reference", 0, true);
+    check_turn("clockwise", 1000, true);
+    check_turn("anticlockwise", -2500, true);
+    check_turn("back and forth", 7, true);
+    check_turn("", -3, true);
+    check_turn("", 1, true);
+
+    yaw_reset_calibration_state();
+    check_turn("after resetting", 123, false);
+    check_reference();
+    check_turn("at the reference again", 0, true);
+    check_turn("clockwise", 449, true);
+
+    // 1 ms, 10 ms and 50 ms between edges
+    check_rate("fast clockwise", 2000, 40000);
+    check_rate("slow anticlockwise", -200, 400000);
+    check_rate("very slow clockwise", 40, 2000000);
+    check_turn("after turning", 0, true);
+
+    printf("%s\n", g_failures == 0 ? "passed" : "FAILED");
+    return g_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
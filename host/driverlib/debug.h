@@ -0,0 +1,31 @@
+/*******************************************************************************
+ *
+ * debug.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's driverlib/debug.h.
+ * Only the parts used by this project are provided. The functions are
+ * implemented by the host HAL (hal.c).
+ *
+ ******************************************************************************/
+
+#ifndef __DRIVERLIB_DEBUG_H__
+#define __DRIVERLIB_DEBUG_H__
+
+#include <assert.h>
+
+#ifdef DEBUG
+#define ASSERT(expr) assert(expr)
+#else
+#define ASSERT(expr)
+#endif
+
+#endif /* __DRIVERLIB_DEBUG_H__ */
@@ -0,0 +1,30 @@
+/*******************************************************************************
+ *
+ * pin_map.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's driverlib/pin_map.h.
+ * Only the parts used by this project are provided. The functions are
+ * implemented by the host HAL (hal.c).
+ *
+ ******************************************************************************/
+
+#ifndef __DRIVERLIB_PIN_MAP_H__
+#define __DRIVERLIB_PIN_MAP_H__
+
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PC5_M0PWM7         0x00021404
+#define GPIO_PD6_PHA0           0x00031806
+#define GPIO_PD7_PHB0           0x00031C06
+#define GPIO_PF1_M1PWM5         0x00050405
+
+#endif /* __DRIVERLIB_PIN_MAP_H__ */
@@ -0,0 +1,57 @@
+/*******************************************************************************
+ *
+ * qei.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's driverlib/qei.h.
+ * Only the parts used by this project are provided. The functions are
+ * implemented by the host HAL (hal.c).
+ *
+ ******************************************************************************/
+
+#ifndef __DRIVERLIB_QEI_H__
+#define __DRIVERLIB_QEI_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define QEI_CONFIG_CAPTURE_A    0x00000000
+#define QEI_CONFIG_CAPTURE_A_B  0x00000008
+#define QEI_CONFIG_NO_RESET     0x00000000
+#define QEI_CONFIG_RESET_IDX    0x00000010
+#define QEI_CONFIG_QUADRATURE   0x00000000
+#define QEI_CONFIG_CLOCK_DIR    0x00000004
+#define QEI_CONFIG_NO_SWAP      0x00000000
+#define QEI_CONFIG_SWAP         0x00000002
+
+#define QEI_VELDIV_1            0x00000000
+
+#define QEI_INTERROR            0x00000008
+#define QEI_INTDIR              0x00000004
+#define QEI_INTTIMER            0x00000002
+#define QEI_INTINDEX            0x00000001
+
+extern void QEIEnable(uint32_t ui32Base);
+extern void QEIDisable(uint32_t ui32Base);
+extern void QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition);
+extern uint32_t QEIPositionGet(uint32_t ui32Base);
+extern void QEIPositionSet(uint32_t ui32Base, uint32_t ui32Position);
+extern void QEIVelocityEnable(uint32_t ui32Base);
+extern void QEIVelocityDisable(uint32_t ui32Base);
+extern void QEIVelocityConfigure(uint32_t ui32Base, uint32_t ui32PreDiv, uint32_t ui32Period);
+extern uint32_t QEIVelocityGet(uint32_t ui32Base);
+extern void QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+extern void QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void QEIIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern uint32_t QEIIntStatus(uint32_t ui32Base, bool bMasked);
+extern void QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+#endif /* __DRIVERLIB_QEI_H__ */
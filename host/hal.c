@@ -0,0 +1,1384 @@
+/*******************************************************************************
+ *
+ * hal.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module simulates the parts of the Tiva board that the firmware uses so
+ * that it can be built and run on the host computer. Every driverlib function
+ * that the firmware calls is implemented here against a small model of the
+ * peripheral. Interrupts are delivered as soon as they are raised unless
+ * interrupts are masked or another handler is running, in which case they
+ * are held pending until they can be delivered.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+#include "inc/tm4c123gh6pm.h"
+#include "driverlib/adc.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
+#include "driverlib/qei.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+#include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#include "hal.h"
+#include "kernel.h"
+
+/**
+ * The processor clock rate set up by clock_init (in Hz).
+ */
+static const uint32_t HAL_CLOCK_RATE = 40000000;
+
+/**
+ * The number of cycles that SysCtlDelay takes per count.
+ */
+static const uint32_t HAL_DELAY_CYCLES_PER_COUNT = 3;
+
+/**
+ * The number of cycles between triggering an ADC conversion and the result
+ * being ready (the ADC converts at 1 Msps).
+ */
+static const uint32_t HAL_ADC_CONVERSION_CYCLES = 40;
+
+/**
+ * The ADC value returned before anything has been injected. This is roughly
+ * where the helicopter sits when landed.
+ */
+static const uint16_t HAL_ADC_DEFAULT_VALUE = 2500;
+
+/**
+ * Used as the time of an event that will never happen.
+ */
+static const uint64_t HAL_NEVER = UINT64_MAX;
+
+#define HAL_ADC_QUEUE_SIZE 256
+#define HAL_UART_BUFFER_SIZE 4096
+#define HAL_REGISTER_COUNT 16
+#define HAL_GPIO_PORT_COUNT 6
+#define HAL_PWM_MODULE_COUNT 2
+#define HAL_PWM_GEN_COUNT 4
+#define HAL_PWM_OUT_COUNT 8
+#define HAL_TIMER_COUNT 3
+#define HAL_EEPROM_SIZE 2048
+#define HAL_ADC_STEP_COUNT 8
+#define HAL_ADC_CHANNEL_COUNT 12
+
+/**
+ * The interrupt sources that the simulation can raise, in order of priority.
+ */
+enum hal_int_e {
+    HAL_INT_SYSTICK = 0,
+    HAL_INT_TIMER0A,
+    HAL_INT_TIMER1A,
+    HAL_INT_TIMER2A,
+    HAL_INT_ADC0,
+    HAL_INT_QEI0,
+    HAL_INT_GPIOA,
+    HAL_INT_COUNT = HAL_INT_GPIOA + HAL_GPIO_PORT_COUNT
+};
+
+typedef struct {
+    uint32_t address;
+    uint32_t value;
+} HalRegister;
+
+typedef struct {
+    uint8_t levels;
+    uint8_t rising;
+    uint8_t falling;
+    uint8_t int_mask;
+    uint8_t int_status;
+} HalGpioPort;
+
+typedef struct {
+    bool enabled;
+    bool adc_trigger;
+    uint64_t start_cycles;
+    uint32_t load;
+    uint32_t match;
+    uint32_t int_mask;
+    uint32_t int_status;
+} HalTimer;
+
+typedef struct {
+    uint32_t mode;
+    uint16_t* destination;
+    uint32_t size;
+    uint32_t done;
+} HalDmaTransfer;
+
+typedef struct {
+    bool enabled;
+    uint32_t config;
+    uint32_t max_position;
+    uint32_t position;
+    uint8_t pins;
+    uint8_t previous_state;
+    bool velocity_enabled;
+    uint32_t velocity_period;
+    uint64_t velocity_start;
+    uint32_t pulses;
+    uint32_t velocity;
+    uint32_t int_mask;
+    uint32_t int_status;
+} HalQei;
+
+typedef struct {
+    uint32_t period[HAL_PWM_GEN_COUNT];
+    uint32_t width[HAL_PWM_OUT_COUNT];
+    uint32_t enabled;
+} HalPwmModule;
+
+// the simulated time
+static uint64_t g_cycles = 0;
+
+// interrupt delivery
+static void (*g_handlers[HAL_INT_COUNT])(void);
+static uint32_t g_pending = 0;
+static bool g_master_enabled = true;
+static bool g_in_handler = false;
+
+// the small number of registers accessed directly through HWREG
+static HalRegister g_registers[HAL_REGISTER_COUNT];
+static uint8_t g_register_total = 0;
+
+// SysTick
+static uint32_t g_systick_period = 1;
+static bool g_systick_enabled = false;
+static bool g_systick_int_enabled = false;
+static uint64_t g_systick_start = 0;
+
+// general purpose timers
+static HalTimer g_timers[HAL_TIMER_COUNT];
+
+// ADC (the one sequence that the firmware uses). the queue feeds the
+// altitude input (channel 9) and the other channels hold a set value.
+static uint16_t g_adc_queue[HAL_ADC_QUEUE_SIZE];
+static uint16_t g_adc_head = 0;
+static uint16_t g_adc_tail = 0;
+static uint16_t g_adc_raw = HAL_ADC_DEFAULT_VALUE;
+static uint16_t g_adc_channels[HAL_ADC_CHANNEL_COUNT];
+static uint32_t g_adc_steps[HAL_ADC_STEP_COUNT] = { ADC_CTL_CH9 };
+static uint8_t g_adc_step_count = 1;
+static uint16_t g_adc_values[HAL_ADC_STEP_COUNT] = { HAL_ADC_DEFAULT_VALUE };
+static uint64_t g_adc_due = UINT64_MAX;
+static uint32_t g_adc_trigger = ADC_TRIGGER_PROCESSOR;
+static uint32_t g_adc_oversample = 1;
+static bool g_adc_dma_enabled = false;
+static uint32_t g_adc_samples = 0;
+static uint32_t g_adc_conversions = 0;
+static uint32_t g_adc_interrupts = 0;
+static uint32_t g_adc_processor_triggers = 0;
+
+// uDMA (the ADC sequence 3 channel only). the primary and alternate
+// transfers are used in turn in ping-pong mode.
+static HalDmaTransfer g_dma[2];
+static uint8_t g_dma_active = 0;
+static bool g_dma_enabled = false;
+static bool g_adc_int_enabled = false;
+static bool g_adc_int_status = false;
+
+// GPIO
+static HalGpioPort g_gpio[HAL_GPIO_PORT_COUNT];
+
+// QEI0, fed by PD6 (phase A) and PD7 (phase B) once they are given to it
+static HalQei g_qei;
+
+// PWM
+static HalPwmModule g_pwm[HAL_PWM_MODULE_COUNT];
+
+// UART0 transmit
+static char g_uart_buffer[HAL_UART_BUFFER_SIZE];
+static uint32_t g_uart_head = 0;
+static uint32_t g_uart_tail = 0;
+
+static bool g_reset_requested = false;
+
+// the registers that the firmware writes to directly
+volatile uint32_t GPIO_PORTD_LOCK_R;
+volatile uint32_t GPIO_PORTD_CR_R;
+volatile uint32_t GPIO_PORTF_LOCK_R;
+volatile uint32_t GPIO_PORTF_CR_R;
+
+/*******************************************************************************
+ * Interrupt delivery
+ ******************************************************************************/
+
+/**
+ * Runs the pending handlers if interrupts are allowed.
+ */
+static void hal_deliver(void)
+{
+    while (g_master_enabled && !g_in_handler && g_pending != 0)
+    {
+        uint8_t source = 0;
+        while ((g_pending & (1ul << source)) == 0)
+        {
+            source++;
+        }
+        g_pending &= ~(1ul << source);
+
+        if (g_handlers[source] != NULL)
+        {
+            g_in_handler = true;
+            g_handlers[source]();
+            g_in_handler = false;
+        }
+    }
+}
+
+/**
+ * Marks an interrupt as pending and delivers it if possible.
+ */
+static void hal_raise(uint8_t t_source)
+{
+    g_pending |= 1ul << t_source;
+    hal_deliver();
+}
+
+bool IntMasterEnable(void)
+{
+    bool was_disabled = !g_master_enabled;
+    g_master_enabled = true;
+    hal_deliver();
+    return was_disabled;
+}
+
+bool IntMasterDisable(void)
+{
+    bool was_disabled = !g_master_enabled;
+    g_master_enabled = false;
+    return was_disabled;
+}
+
+void IntEnable(uint32_t ui32Interrupt)
+{
+}
+
+void IntDisable(uint32_t ui32Interrupt)
+{
+}
+
+volatile uint32_t* hal_register(uint32_t t_address)
+{
+    uint8_t i;
+    for (i = 0; i < g_register_total; i++)
+    {
+        if (g_registers[i].address == t_address)
+        {
+            return &g_registers[i].value;
+        }
+    }
+
+    // reuse the last slot rather than fail if the table fills up
+    if (g_register_total < HAL_REGISTER_COUNT)
+    {
+        g_register_total++;
+    }
+    g_registers[g_register_total - 1] = (HalRegister){ t_address, 0 };
+    return &g_registers[g_register_total - 1].value;
+}
+
+/*******************************************************************************
+ * Time
+ ******************************************************************************/
+
+/**
+ * Returns the index of a general purpose timer from its base address.
+ */
+static uint8_t hal_timer_index(uint32_t t_base)
+{
+    return (t_base - TIMER0_BASE) >> 12;
+}
+
+static uint32_t hal_timer_value(const HalTimer* t_timer)
+{
+    return (uint32_t)(g_cycles - t_timer->start_cycles);
+}
+
+/**
+ * Returns the time of the next SysTick interrupt.
+ */
+static uint64_t hal_systick_next(void)
+{
+    if (!g_systick_enabled || !g_systick_int_enabled)
+    {
+        return HAL_NEVER;
+    }
+    uint64_t elapsed = g_cycles - g_systick_start;
+    return g_systick_start + (elapsed / g_systick_period + 1) * g_systick_period;
+}
+
+/**
+ * Returns the time that a timer next reaches its match value.
+ */
+static uint64_t hal_timer_next(uint8_t t_index)
+{
+    const HalTimer* timer = &g_timers[t_index];
+    uint32_t mode = HWREG(TIMER0_BASE + (t_index << 12) + TIMER_O_TAMR);
+
+    if (!timer->enabled || (timer->int_mask & TIMER_TIMA_MATCH) == 0 || (mode & TIMER_TAMR_TAMIE) == 0)
+    {
+        return HAL_NEVER;
+    }
+
+    uint32_t delta = timer->match - hal_timer_value(timer);
+    return g_cycles + (delta == 0 ? (1ull << 32) : delta);
+}
+
+/**
+ * Returns the time that a timer next times out and triggers the ADC. Only
+ * timers set up as ADC triggers are simulated as counting down from their
+ * load value.
+ */
+static uint64_t hal_timer_trigger_next(uint8_t t_index)
+{
+    const HalTimer* timer = &g_timers[t_index];
+
+    if (!timer->enabled || !timer->adc_trigger || g_adc_trigger != ADC_TRIGGER_TIMER)
+    {
+        return HAL_NEVER;
+    }
+
+    uint64_t period = (uint64_t)timer->load + 1;
+    return timer->start_cycles + ((g_cycles - timer->start_cycles) / period + 1) * period;
+}
+
+/**
+ * Returns the time that the QEI velocity timer next expires.
+ */
+static uint64_t hal_qei_timer_next(void)
+{
+    if (!g_qei.enabled || !g_qei.velocity_enabled || g_qei.velocity_period == 0)
+    {
+        return HAL_NEVER;
+    }
+
+    uint64_t period = g_qei.velocity_period;
+    return g_qei.velocity_start + ((g_cycles - g_qei.velocity_start) / period + 1) * period;
+}
+
+/**
+ * Returns the time of the next thing that will raise an interrupt.
+ */
+static uint64_t hal_next_event(void)
+{
+    uint64_t next = hal_systick_next();
+    uint8_t i;
+
+    for (i = 0; i < HAL_TIMER_COUNT; i++)
+    {
+        uint64_t timer_next = hal_timer_next(i);
+        if (timer_next < next)
+        {
+            next = timer_next;
+        }
+
+        timer_next = hal_timer_trigger_next(i);
+        if (timer_next < next)
+        {
+            next = timer_next;
+        }
+    }
+
+    if (g_adc_due < next)
+    {
+        next = g_adc_due;
+    }
+
+    uint64_t qei_next = hal_qei_timer_next();
+    if (qei_next < next)
+    {
+        next = qei_next;
+    }
+
+    return next;
+}
+
+/**
+ * Moves time forward without raising anything.
+ */
+static void hal_step_to(uint64_t t_cycles)
+{
+    kernel_clock_advance((uint32_t)(t_cycles - g_cycles));
+    g_cycles = t_cycles;
+}
+
+/**
+ * Starts a conversion of the sequence unless one is already under way. With
+ * hardware oversampling the sequence takes one conversion per step per
+ * sample averaged.
+ */
+static void hal_adc_start(void)
+{
+    if (g_adc_due == HAL_NEVER)
+    {
+        g_adc_due = g_cycles + HAL_ADC_CONVERSION_CYCLES * g_adc_oversample * g_adc_step_count;
+    }
+}
+
+/**
+ * Hands a sample to the uDMA. Returns true if it finished a transfer, which
+ * is when the ADC interrupt is raised. The sample is lost if the channel
+ * isn't running.
+ */
+static bool hal_dma_write(uint16_t t_value)
+{
+    HalDmaTransfer* transfer = &g_dma[g_dma_active];
+
+    if (!g_dma_enabled || transfer->mode == UDMA_MODE_STOP)
+    {
+        g_dma_enabled = false;
+        return false;
+    }
+
+    transfer->destination[transfer->done++] = t_value;
+    if (transfer->done < transfer->size)
+    {
+        return false;
+    }
+
+    // a ping-pong transfer carries on with the other half, unless that
+    // hasn't been set up again in time
+    if (transfer->mode == UDMA_MODE_PINGPONG)
+    {
+        g_dma_active ^= 1;
+    }
+    transfer->mode = UDMA_MODE_STOP;
+    g_dma_enabled = g_dma[g_dma_active].mode != UDMA_MODE_STOP;
+
+    return true;
+}
+
+/**
+ * Completes the ADC conversion of each step of the sequence that is due now.
+ * Each conversion of the altitude input takes the next raw value from the
+ * queue and the results are averaged when the hardware oversampling is
+ * turned on.
+ */
+static void hal_adc_convert(void)
+{
+    uint32_t sum;
+    uint32_t i;
+    uint8_t step;
+
+    g_adc_due = HAL_NEVER;
+
+    for (step = 0; step < g_adc_step_count; step++)
+    {
+        uint8_t channel = g_adc_steps[step] & 0xF;
+
+        sum = 0;
+        for (i = 0; i < g_adc_oversample; i++)
+        {
+            if (channel != ADC_CTL_CH9)
+            {
+                sum += g_adc_channels[channel % HAL_ADC_CHANNEL_COUNT];
+                continue;
+            }
+
+            if (g_adc_tail != g_adc_head)
+            {
+                g_adc_raw = g_adc_queue[g_adc_tail];
+                g_adc_tail = (g_adc_tail + 1) % HAL_ADC_QUEUE_SIZE;
+            }
+            sum += g_adc_raw;
+        }
+        g_adc_values[step] = sum / g_adc_oversample;
+    }
+    g_adc_conversions += g_adc_oversample * g_adc_step_count;
+    g_adc_samples++;
+
+    // with the uDMA taking the samples, the interrupt is only raised at the
+    // end of each transfer
+    if (g_adc_dma_enabled && !hal_dma_write(g_adc_values[0]))
+    {
+        return;
+    }
+
+    g_adc_int_status = true;
+    if (g_adc_int_enabled)
+    {
+        g_adc_interrupts++;
+        hal_raise(HAL_INT_ADC0);
+    }
+}
+
+void hal_advance(uint32_t t_cycles)
+{
+    uint64_t target = g_cycles + t_cycles;
+    uint64_t next;
+
+    while ((next = hal_next_event()) <= target)
+    {
+        hal_step_to(next);
+
+        if (g_systick_enabled && g_systick_int_enabled && (g_cycles - g_systick_start) % g_systick_period == 0)
+        {
+            hal_raise(HAL_INT_SYSTICK);
+        }
+
+        uint8_t i;
+        for (i = 0; i < HAL_TIMER_COUNT; i++)
+        {
+            if (g_timers[i].enabled && hal_timer_value(&g_timers[i]) == g_timers[i].match
+                    && (g_timers[i].int_mask & TIMER_TIMA_MATCH) != 0)
+            {
+                g_timers[i].int_status |= TIMER_TIMA_MATCH;
+                hal_raise(HAL_INT_TIMER0A + i);
+            }
+
+            // a timer set up as an ADC trigger starts a conversion each time
+            // it times out
+            if (g_timers[i].enabled && g_timers[i].adc_trigger && g_adc_trigger == ADC_TRIGGER_TIMER
+                    && g_cycles != g_timers[i].start_cycles
+                    && (g_cycles - g_timers[i].start_cycles) % ((uint64_t)g_timers[i].load + 1) == 0)
+            {
+                hal_adc_start();
+            }
+        }
+
+        if (g_adc_due == next)
+        {
+            hal_adc_convert();
+        }
+
+        // the QEI velocity timer latches the pulses counted over its period
+        if (g_qei.enabled && g_qei.velocity_enabled
+                && g_cycles != g_qei.velocity_start
+                && (g_cycles - g_qei.velocity_start) % g_qei.velocity_period == 0)
+        {
+            g_qei.velocity = g_qei.pulses;
+            g_qei.pulses = 0;
+            g_qei.int_status |= QEI_INTTIMER;
+            if ((g_qei.int_mask & QEI_INTTIMER) != 0)
+            {
+                hal_raise(HAL_INT_QEI0);
+            }
+        }
+    }
+
+    hal_step_to(target);
+}
+
+uint64_t hal_get_cycles(void)
+{
+    return g_cycles;
+}
+
+/*******************************************************************************
+ * SysCtl
+ ******************************************************************************/
+
+void SysCtlClockSet(uint32_t ui32Config)
+{
+}
+
+uint32_t SysCtlClockGet(void)
+{
+    return HAL_CLOCK_RATE;
+}
+
+void SysCtlDelay(uint32_t ui32Count)
+{
+    hal_advance(ui32Count * HAL_DELAY_CYCLES_PER_COUNT);
+}
+
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral)
+{
+}
+
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral)
+{
+    return true;
+}
+
+void SysCtlPWMClockSet(uint32_t ui32Config)
+{
+}
+
+void SysCtlReset(void)
+{
+    g_reset_requested = true;
+}
+
+void SysCtlSleep(void)
+{
+    // wake at the next interrupt, even if interrupts are masked
+    uint64_t next = hal_next_event();
+    if (next != HAL_NEVER)
+    {
+        hal_advance((uint32_t)(next - g_cycles));
+    }
+}
+
+bool hal_reset_requested(void)
+{
+    return g_reset_requested;
+}
+
+/*******************************************************************************
+ * SysTick
+ ******************************************************************************/
+
+void SysTickEnable(void)
+{
+    g_systick_enabled = true;
+    g_systick_start = g_cycles;
+}
+
+void SysTickDisable(void)
+{
+    g_systick_enabled = false;
+}
+
+void SysTickIntRegister(void (*pfnHandler)(void))
+{
+    g_handlers[HAL_INT_SYSTICK] = pfnHandler;
+}
+
+void SysTickIntEnable(void)
+{
+    g_systick_int_enabled = true;
+}
+
+void SysTickIntDisable(void)
+{
+    g_systick_int_enabled = false;
+}
+
+void SysTickPeriodSet(uint32_t ui32Period)
+{
+    g_systick_period = ui32Period;
+}
+
+uint32_t SysTickPeriodGet(void)
+{
+    return g_systick_period;
+}
+
+uint32_t SysTickValueGet(void)
+{
+    // the counter counts down from period - 1 to 0
+    if (!g_systick_enabled)
+    {
+        return 0;
+    }
+    return g_systick_period - 1 - (uint32_t)((g_cycles - g_systick_start) % g_systick_period);
+}
+
+/*******************************************************************************
+ * Timers (always full width, counting up, with timeouts only for ADC triggers)
+ ******************************************************************************/
+
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    HalTimer* timer = &g_timers[hal_timer_index(ui32Base)];
+    timer->enabled = true;
+    timer->start_cycles = g_cycles;
+}
+
+void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    g_timers[hal_timer_index(ui32Base)].enabled = false;
+}
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config)
+{
+}
+
+void TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable)
+{
+    g_timers[hal_timer_index(ui32Base)].adc_trigger = bEnable;
+}
+
+void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value)
+{
+    g_timers[hal_timer_index(ui32Base)].load = ui32Value;
+}
+
+uint32_t TimerValueGet(uint32_t ui32Base, uint32_t ui32Timer)
+{
+    return hal_timer_value(&g_timers[hal_timer_index(ui32Base)]);
+}
+
+void TimerMatchSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value)
+{
+    g_timers[hal_timer_index(ui32Base)].match = ui32Value;
+}
+
+void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void))
+{
+    g_handlers[HAL_INT_TIMER0A + hal_timer_index(ui32Base)] = pfnHandler;
+}
+
+void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_timers[hal_timer_index(ui32Base)].int_mask |= ui32IntFlags;
+}
+
+void TimerIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_timers[hal_timer_index(ui32Base)].int_mask &= ~ui32IntFlags;
+}
+
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_timers[hal_timer_index(ui32Base)].int_status &= ~ui32IntFlags;
+}
+
+/*******************************************************************************
+ * ADC (one sequence only)
+ ******************************************************************************/
+
+bool hal_adc_inject(uint16_t t_value)
+{
+    uint16_t next_head = (g_adc_head + 1) % HAL_ADC_QUEUE_SIZE;
+    if (next_head == g_adc_tail)
+    {
+        return false;
+    }
+    g_adc_queue[g_adc_head] = t_value;
+    g_adc_head = next_head;
+    return true;
+}
+
+void hal_adc_set_channel(uint8_t t_channel, uint16_t t_value)
+{
+    g_adc_channels[t_channel % HAL_ADC_CHANNEL_COUNT] = t_value;
+}
+
+void ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum, void (*pfnHandler)(void))
+{
+    g_handlers[HAL_INT_ADC0] = pfnHandler;
+}
+
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    g_adc_int_status = false;
+    g_adc_int_enabled = true;
+}
+
+void ADCIntDisable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    g_adc_int_enabled = false;
+}
+
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    g_adc_int_status = false;
+}
+
+uint32_t ADCIntStatus(uint32_t ui32Base, uint32_t ui32SequenceNum, bool bMasked)
+{
+    return g_adc_int_status && (g_adc_int_enabled || !bMasked);
+}
+
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+}
+
+void ADCSequenceDisable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+}
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Trigger, uint32_t ui32Priority)
+{
+    g_adc_trigger = ui32Trigger;
+}
+
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Step, uint32_t ui32Config)
+{
+    g_adc_steps[ui32Step % HAL_ADC_STEP_COUNT] = ui32Config;
+    if (ui32Config & ADC_CTL_END)
+    {
+        g_adc_step_count = ui32Step % HAL_ADC_STEP_COUNT + 1;
+    }
+}
+
+int32_t ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t *pui32Buffer)
+{
+    uint8_t step;
+
+    for (step = 0; step < g_adc_step_count; step++)
+    {
+        pui32Buffer[step] = g_adc_values[step];
+    }
+    return g_adc_step_count;
+}
+
+void ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    // a trigger during a conversion is ignored
+    g_adc_processor_triggers++;
+    hal_adc_start();
+}
+
+void ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor)
+{
+    g_adc_oversample = ui32Factor == 0 ? 1 : ui32Factor;
+}
+
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum)
+{
+    g_adc_dma_enabled = true;
+}
+
+uint32_t hal_adc_get_counts(uint32_t* t_conversions, uint32_t* t_interrupts, uint32_t* t_processor_triggers)
+{
+    *t_conversions = g_adc_conversions;
+    *t_interrupts = g_adc_interrupts;
+    *t_processor_triggers = g_adc_processor_triggers;
+    return g_adc_samples;
+}
+
+/*******************************************************************************
+ * uDMA (the ADC sequence 3 channel only)
+ ******************************************************************************/
+
+void uDMAEnable(void)
+{
+}
+
+void uDMAControlBaseSet(void *pControlTable)
+{
+}
+
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr)
+{
+}
+
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control)
+{
+}
+
+void uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode, void *pvSrcAddr,
+                            void *pvDstAddr, uint32_t ui32TransferSize)
+{
+    HalDmaTransfer* transfer = &g_dma[(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0];
+
+    transfer->mode = ui32Mode;
+    transfer->destination = pvDstAddr;
+    transfer->size = ui32TransferSize;
+    transfer->done = 0;
+}
+
+void uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    // a channel always starts on its primary transfer
+    if (!g_dma_enabled)
+    {
+        g_dma_active = 0;
+    }
+    g_dma_enabled = true;
+}
+
+bool uDMAChannelIsEnabled(uint32_t ui32ChannelNum)
+{
+    return g_dma_enabled;
+}
+
+uint32_t uDMAChannelModeGet(uint32_t ui32ChannelStructIndex)
+{
+    return g_dma[(ui32ChannelStructIndex & UDMA_ALT_SELECT) != 0].mode;
+}
+
+/*******************************************************************************
+ * GPIO
+ ******************************************************************************/
+
+/**
+ * Returns the index of a GPIO port (0 for port A) from its base address.
+ */
+static uint8_t hal_gpio_index(uint32_t t_port)
+{
+    if (t_port >= GPIO_PORTE_BASE)
+    {
+        return 4 + ((t_port - GPIO_PORTE_BASE) >> 12);
+    }
+    return (t_port - GPIO_PORTA_BASE) >> 12;
+}
+
+/**
+ * Returns the state of the QEI phases as (A << 1) | B, after any swap.
+ */
+static uint8_t hal_qei_state(void)
+{
+    uint8_t levels = g_gpio[hal_gpio_index(GPIO_PORTD_BASE)].levels;
+    bool phase_a = (levels & GPIO_PIN_6) != 0;
+    bool phase_b = (levels & GPIO_PIN_7) != 0;
+
+    if ((g_qei.config & QEI_CONFIG_SWAP) != 0)
+    {
+        return (phase_b << 1) | phase_a;
+    }
+    return (phase_a << 1) | phase_b;
+}
+
+/**
+ * Counts a change of the QEI phases. The position counts up when phase A
+ * leads phase B and wraps between 0 and the maximum position. A change of
+ * both phases at once is an error and isn't counted.
+ */
+static void hal_qei_update(void)
+{
+    // indexed by (previous state << 2) | this state
+    static const int8_t QEI_DELTAS[16] = {
+        0, -1, 1, 0,
+        1, 0, 0, -1,
+        -1, 0, 0, 1,
+        0, 1, -1, 0
+    };
+
+    uint8_t state = hal_qei_state();
+    uint8_t previous_state = g_qei.previous_state;
+    g_qei.previous_state = state;
+
+    if (!g_qei.enabled)
+    {
+        return;
+    }
+
+    // without capturing both phases only the edges of phase A are counted
+    if ((g_qei.config & QEI_CONFIG_CAPTURE_A_B) == 0 && ((state ^ previous_state) & 2) == 0)
+    {
+        return;
+    }
+
+    int8_t delta = QEI_DELTAS[(previous_state << 2) | state];
+    if (delta > 0)
+    {
+        g_qei.position = g_qei.position >= g_qei.max_position ? 0 : g_qei.position + 1;
+        g_qei.pulses++;
+    }
+    else if (delta < 0)
+    {
+        g_qei.position = g_qei.position == 0 ? g_qei.max_position : g_qei.position - 1;
+        g_qei.pulses++;
+    }
+}
+
+void hal_gpio_set(uint32_t t_port, uint8_t t_pins, uint8_t t_levels)
+{
+    uint8_t index = hal_gpio_index(t_port);
+    HalGpioPort* port = &g_gpio[index];
+
+    uint8_t levels = (port->levels & ~t_pins) | (t_levels & t_pins);
+    uint8_t rose = levels & ~port->levels;
+    uint8_t fell = port->levels & ~levels;
+    port->levels = levels;
+
+    if (t_port == GPIO_PORTD_BASE && ((rose | fell) & g_qei.pins) != 0)
+    {
+        hal_qei_update();
+    }
+
+    port->int_status |= (rose & port->rising) | (fell & port->falling);
+    if ((port->int_status & port->int_mask) != 0)
+    {
+        hal_raise(HAL_INT_GPIOA + index);
+    }
+}
+
+uint8_t hal_gpio_get(uint32_t t_port)
+{
+    return g_gpio[hal_gpio_index(t_port)].levels;
+}
+
+void GPIODirModeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32PinIO)
+{
+}
+
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32IntType)
+{
+    HalGpioPort* port = &g_gpio[hal_gpio_index(ui32Port)];
+
+    port->rising &= ~ui8Pins;
+    port->falling &= ~ui8Pins;
+
+    // level interrupts are treated as edges into that level
+    if (ui32IntType == GPIO_BOTH_EDGES || ui32IntType == GPIO_RISING_EDGE || ui32IntType == GPIO_HIGH_LEVEL)
+    {
+        port->rising |= ui8Pins;
+    }
+    if (ui32IntType == GPIO_BOTH_EDGES || ui32IntType == GPIO_FALLING_EDGE || ui32IntType == GPIO_LOW_LEVEL)
+    {
+        port->falling |= ui8Pins;
+    }
+}
+
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength, uint32_t ui32PadType)
+{
+    // inputs settle at the level of their weak pull up or pull down
+    HalGpioPort* port = &g_gpio[hal_gpio_index(ui32Port)];
+    if (ui32PadType == GPIO_PIN_TYPE_STD_WPU)
+    {
+        port->levels |= ui8Pins;
+    }
+    else if (ui32PadType == GPIO_PIN_TYPE_STD_WPD)
+    {
+        port->levels &= ~ui8Pins;
+    }
+}
+
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    g_gpio[hal_gpio_index(ui32Port)].int_mask |= ui32IntFlags;
+}
+
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    g_gpio[hal_gpio_index(ui32Port)].int_mask &= ~ui32IntFlags;
+}
+
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked)
+{
+    const HalGpioPort* port = &g_gpio[hal_gpio_index(ui32Port)];
+    return bMasked ? port->int_status & port->int_mask : port->int_status;
+}
+
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    g_gpio[hal_gpio_index(ui32Port)].int_status &= ~ui32IntFlags;
+}
+
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void))
+{
+    g_handlers[HAL_INT_GPIOA + hal_gpio_index(ui32Port)] = pfnIntHandler;
+}
+
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    return g_gpio[hal_gpio_index(ui32Port)].levels & ui8Pins;
+}
+
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    hal_gpio_set(ui32Port, ui8Pins, ui8Val);
+}
+
+void GPIOPinConfigure(uint32_t ui32PinConfig)
+{
+}
+
+void GPIOPinTypeADC(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void GPIOPinTypeGPIOOutput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void GPIOPinTypeQEI(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    if (ui32Port == GPIO_PORTD_BASE)
+    {
+        g_qei.pins |= ui8Pins & (GPIO_PIN_6 | GPIO_PIN_7);
+    }
+}
+
+void GPIOPinTypeSSI(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins)
+{
+}
+
+/*******************************************************************************
+ * QEI (QEI0 only)
+ ******************************************************************************/
+
+void QEIEnable(uint32_t ui32Base)
+{
+    g_qei.enabled = true;
+    g_qei.previous_state = hal_qei_state();
+    g_qei.velocity_start = g_cycles;
+}
+
+void QEIDisable(uint32_t ui32Base)
+{
+    g_qei.enabled = false;
+}
+
+void QEIConfigure(uint32_t ui32Base, uint32_t ui32Config, uint32_t ui32MaxPosition)
+{
+    g_qei.config = ui32Config;
+    g_qei.max_position = ui32MaxPosition;
+}
+
+uint32_t QEIPositionGet(uint32_t ui32Base)
+{
+    return g_qei.position;
+}
+
+void QEIPositionSet(uint32_t ui32Base, uint32_t ui32Position)
+{
+    g_qei.position = ui32Position;
+}
+
+void QEIVelocityEnable(uint32_t ui32Base)
+{
+    g_qei.velocity_enabled = true;
+    g_qei.velocity_start = g_cycles;
+    g_qei.pulses = 0;
+}
+
+void QEIVelocityDisable(uint32_t ui32Base)
+{
+    g_qei.velocity_enabled = false;
+}
+
+void QEIVelocityConfigure(uint32_t ui32Base, uint32_t ui32PreDiv, uint32_t ui32Period)
+{
+    g_qei.velocity_period = ui32Period;
+}
+
+uint32_t QEIVelocityGet(uint32_t ui32Base)
+{
+    return g_qei.velocity;
+}
+
+void QEIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    g_handlers[HAL_INT_QEI0] = pfnHandler;
+}
+
+void QEIIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_qei.int_mask |= ui32IntFlags;
+}
+
+void QEIIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_qei.int_mask &= ~ui32IntFlags;
+}
+
+uint32_t QEIIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    return bMasked ? g_qei.int_status & g_qei.int_mask : g_qei.int_status;
+}
+
+void QEIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_qei.int_status &= ~ui32IntFlags;
+}
+
+/*******************************************************************************
+ * PWM
+ ******************************************************************************/
+
+static HalPwmModule* hal_pwm_module(uint32_t t_base)
+{
+    return &g_pwm[(t_base - PWM0_BASE) >> 12];
+}
+
+/**
+ * Returns the index of a generator (0 to 3) from a PWM_GEN_x or PWM_OUT_x
+ * value.
+ */
+static uint8_t hal_pwm_gen_index(uint32_t t_gen)
+{
+    return ((t_gen & 0xFC0) >> 6) - 1;
+}
+
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config)
+{
+}
+
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period)
+{
+    hal_pwm_module(ui32Base)->period[hal_pwm_gen_index(ui32Gen)] = ui32Period;
+}
+
+uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    return hal_pwm_module(ui32Base)->period[hal_pwm_gen_index(ui32Gen)];
+}
+
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen)
+{
+}
+
+void PWMGenDisable(uint32_t ui32Base, uint32_t ui32Gen)
+{
+}
+
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width)
+{
+    hal_pwm_module(ui32Base)->width[ui32PWMOut & 7] = ui32Width;
+}
+
+uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut)
+{
+    return hal_pwm_module(ui32Base)->width[ui32PWMOut & 7];
+}
+
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable)
+{
+    HalPwmModule* module = hal_pwm_module(ui32Base);
+    if (bEnable)
+    {
+        module->enabled |= ui32PWMOutBits;
+    }
+    else
+    {
+        module->enabled &= ~ui32PWMOutBits;
+    }
+}
+
+uint8_t hal_pwm_get_duty(uint32_t t_base, uint32_t t_out)
+{
+    const HalPwmModule* module = hal_pwm_module(t_base);
+    uint32_t period = module->period[hal_pwm_gen_index(t_out)];
+
+    if ((module->enabled & (1ul << (t_out & 7))) == 0 || period == 0)
+    {
+        return 0;
+    }
+
+    return (module->width[t_out & 7] * 100 + period / 2) / period;
+}
+
+/*******************************************************************************
+ * UART (transmit only)
+ ******************************************************************************/
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud, uint32_t ui32Config)
+{
+}
+
+void UARTEnable(uint32_t ui32Base)
+{
+}
+
+void UARTFIFOEnable(uint32_t ui32Base)
+{
+}
+
+bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData)
+{
+    uint32_t next_head = (g_uart_head + 1) % HAL_UART_BUFFER_SIZE;
+    if (next_head == g_uart_tail)
+    {
+        return false;
+    }
+    g_uart_buffer[g_uart_head] = ucData;
+    g_uart_head = next_head;
+    return true;
+}
+
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+{
+    // nobody is reading the other end, so drop the character rather than block
+    UARTCharPutNonBlocking(ui32Base, ucData);
+}
+
+uint32_t hal_uart_read(char* t_buffer, uint32_t t_size)
+{
+    uint32_t count = 0;
+    while (count < t_size && g_uart_tail != g_uart_head)
+    {
+        t_buffer[count++] = g_uart_buffer[g_uart_tail];
+        g_uart_tail = (g_uart_tail + 1) % HAL_UART_BUFFER_SIZE;
+    }
+    return count;
+}
+
+/*******************************************************************************
+ * EEPROM
+ ******************************************************************************/
+
+// the EEPROM contents (erased to all ones) and the file that holds them
+// between runs, if there is one
+static uint32_t g_eeprom[HAL_EEPROM_SIZE / 4];
+static const char* g_eeprom_path = NULL;
+
+bool hal_eeprom_open(const char* t_path)
+{
+    FILE* file;
+
+    memset(g_eeprom, 0xFF, sizeof(g_eeprom));
+    g_eeprom_path = t_path;
+
+    // a file that doesn't exist yet is an erased EEPROM
+    file = fopen(t_path, "rb");
+    if (file == NULL)
+    {
+        return true;
+    }
+
+    bool ok = fread(g_eeprom, 1, sizeof(g_eeprom), file) == sizeof(g_eeprom);
+    fclose(file);
+    return ok;
+}
+
+/**
+ * Writes the EEPROM contents back to its file.
+ */
+static void hal_eeprom_save(void)
+{
+    FILE* file;
+
+    if (g_eeprom_path == NULL)
+    {
+        return;
+    }
+
+    file = fopen(g_eeprom_path, "wb");
+    if (file != NULL)
+    {
+        fwrite(g_eeprom, 1, sizeof(g_eeprom), file);
+        fclose(file);
+    }
+}
+
+uint32_t EEPROMInit(void)
+{
+    return EEPROM_INIT_OK;
+}
+
+uint32_t EEPROMSizeGet(void)
+{
+    return HAL_EEPROM_SIZE;
+}
+
+void EEPROMRead(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count)
+{
+    memcpy(pui32Data, (uint8_t*)g_eeprom + ui32Address, ui32Count);
+}
+
+uint32_t EEPROMProgram(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count)
+{
+    memcpy((uint8_t*)g_eeprom + ui32Address, pui32Data, ui32Count);
+    hal_eeprom_save();
+    return 0;
+}
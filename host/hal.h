@@ -0,0 +1,102 @@
+/*******************************************************************************
+ *
+ * hal.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module simulates the parts of the Tiva board that the firmware uses so
+ * that it can be built and run on the host computer. Time only moves when
+ * hal_advance is called, which makes every run deterministic.
+ *
+ ******************************************************************************/
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Moves simulated time forward by some number of processor cycles, raising
+ * any interrupts (SysTick, timer match, ADC conversion complete, QEI
+ * velocity timer) that fall due along the way.
+ */
+void hal_advance(uint32_t t_cycles);
+
+/**
+ * Returns the number of processor cycles simulated since start up.
+ */
+uint64_t hal_get_cycles(void);
+
+/**
+ * Queues a value to be returned by a future ADC conversion. The last value
+ * converted is repeated once the queue runs dry.
+ * Returns false if the queue is full.
+ */
+bool hal_adc_inject(uint16_t t_value);
+
+/**
+ * Sets the value that the ADC reads from an input other than the altitude
+ * (channel 9), such as the auxiliary channels. These start at 0.
+ */
+void hal_adc_set_channel(uint8_t t_channel, uint16_t t_value);
+
+/**
+ * Returns the number of results the ADC sequence has delivered. The number
+ * of conversions done, the number of interrupts raised and the number of
+ * processor triggers are written to the arguments. There are more
+ * conversions than results when the hardware oversampling is on or the
+ * sequence has more than one step, and fewer interrupts than results when
+ * the uDMA takes them.
+ */
+uint32_t hal_adc_get_counts(uint32_t* t_conversions, uint32_t* t_interrupts, uint32_t* t_processor_triggers);
+
+/**
+ * Sets the input levels of some pins on a GPIO port, raising the port's
+ * interrupt if the change matches the configured edge type.
+ */
+void hal_gpio_set(uint32_t t_port, uint8_t t_pins, uint8_t t_levels);
+
+/**
+ * Returns the current levels of a GPIO port.
+ */
+uint8_t hal_gpio_get(uint32_t t_port);
+
+/**
+ * Returns the duty cycle of a PWM output as a percentage.
+ * This is 0 if the output is disabled.
+ */
+uint8_t hal_pwm_get_duty(uint32_t t_base, uint32_t t_out);
+
+/**
+ * Copies up to t_size bytes sent out of the UART into t_buffer.
+ * Returns the number of bytes copied.
+ */
+uint32_t hal_uart_read(char* t_buffer, uint32_t t_size);
+
+/**
+ * Returns a line of text that is currently on the OLED display.
+ */
+const char* hal_oled_get_line(uint8_t t_row);
+
+/**
+ * Backs the EEPROM with a file, which is read now and written whenever the
+ * EEPROM is programmed. The EEPROM starts erased if the file doesn't exist.
+ * Without a file the EEPROM starts erased on every run.
+ * Returns false if the file couldn't be read.
+ */
+bool hal_eeprom_open(const char* t_path);
+
+/**
+ * Returns true if the firmware has asked for the processor to be reset.
+ */
+bool hal_reset_requested(void);
+
+#endif /* HAL_H_ */
@@ -0,0 +1,171 @@
+/*******************************************************************************
+ *
+ * host_main.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Runs the firmware on the host computer for a number of simulated seconds.
+ *
+ * Usage: heli-host [seconds] [adc trace] [eeprom file]
+ *
+ * The ADC trace is a text file with one raw ADC sample per line. The samples
+ * are fed to the altitude ADC in order and the last one is held once the file
+ * runs out ("-" means no trace). Everything sent out of the UART is written
+ * to stdout, followed by the final contents of the display. The wall clock
+ * time taken and the ADC activity are written to stderr.
+ *
+ * The EEPROM file holds the EEPROM between runs (such as the stored altitude
+ * calibration). It is created when the firmware first programs the EEPROM.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "driverlib/sysctl.h"
+
+#include "altitude.h"
+#include "config.h"
+#include "hal.h"
+#include "kernel.h"
+
+/**
+ * The number of seconds to simulate if none is given.
+ */
+static const uint32_t HOST_DEFAULT_SECONDS = 10;
+
+/**
+ * The number of cycles simulated between passes of the kernel. This is one
+ * tick of the periodic kernel.
+ */
+static const uint32_t HOST_PASS_CYCLES = 100;
+
+/**
+ * The raw value of the auxiliary supply input (channel 0). This is a 5 V
+ * supply through the 2:1 divider.
+ */
+static const uint16_t HOST_SUPPLY_ADC = 3102;
+
+// defined in main.c
+void initialise(void);
+
+/**
+ * Tops up the ADC queue from the trace file.
+ */
+static void host_feed_adc(FILE* t_trace)
+{
+    static bool has_pending = false;
+    static unsigned int pending;
+
+    while (t_trace != NULL)
+    {
+        if (!has_pending)
+        {
+            if (fscanf(t_trace, "%u", &pending) != 1)
+            {
+                return;
+            }
+            has_pending = true;
+        }
+
+        if (!hal_adc_inject(pending))
+        {
+            return;
+        }
+        has_pending = false;
+    }
+}
+
+/**
+ * Copies everything sent out of the UART to stdout.
+ */
+static void host_drain_uart(void)
+{
+    char buffer[256];
+    uint32_t count;
+
+    while ((count = hal_uart_read(buffer, sizeof(buffer))) > 0)
+    {
+        fwrite(buffer, 1, count, stdout);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t seconds = argc > 1 ? strtoul(argv[1], NULL, 10) : HOST_DEFAULT_SECONDS;
+    FILE* trace = NULL;
+    uint8_t row;
+
+    if (argc > 2 && strcmp(argv[2], "-") != 0)
+    {
+        trace = fopen(argv[2], "r");
+        if (trace == NULL)
+        {
+            perror(argv[2]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (argc > 3 && !hal_eeprom_open(argv[3]))
+    {
+        fprintf(stderr, "%s: not an EEPROM image\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    clock_t wall_start = clock();
+
+    host_feed_adc(trace);
+    hal_adc_set_channel(0, HOST_SUPPLY_ADC);
+    initialise();
+
+    uint64_t end_cycles = hal_get_cycles() + (uint64_t)seconds * SysCtlClockGet();
+    while (hal_get_cycles() < end_cycles && !hal_reset_requested())
+    {
+        kernel_run();
+        hal_advance(HOST_PASS_CYCLES);
+
+        host_feed_adc(trace);
+        host_drain_uart();
+    }
+
+    printf("\n");
+    for (row = 0; row < 4; row++)
+    {
+        printf("|%s|\n", hal_oled_get_line(row));
+    }
+
+    double wall_seconds = (double)(clock() - wall_start) / CLOCKS_PER_SEC;
+    double simulated_seconds = (double)hal_get_cycles() / SysCtlClockGet();
+    fprintf(stderr, "simulated %.2f s in %.2f s (%.1fx real time)%s\n",
+            simulated_seconds, wall_seconds, simulated_seconds / wall_seconds,
+            hal_reset_requested() ? ", stopped by a reset" : "");
+
+    // the cost of getting the altitude samples in
+    uint32_t conversions;
+    uint32_t interrupts;
+    uint32_t processor_triggers;
+    uint32_t samples = hal_adc_get_counts(&conversions, &interrupts, &processor_triggers);
+    fprintf(stderr, "adc: %u samples from %u conversions, %u interrupts, %u processor triggers\n",
+            samples, conversions, interrupts, processor_triggers);
+#if ALT_ADC_DMA
+    fprintf(stderr, "adc: the uDMA stopped %u times waiting for the blocks to be read\n", alt_get_dma_stalls());
+#endif
+
+    if (trace != NULL)
+    {
+        fclose(trace);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,24 @@
+/*******************************************************************************
+ *
+ * hw_adc.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's inc/hw_adc.h.
+ * Only the parts used by this project are provided.
+ *
+ ******************************************************************************/
+
+#ifndef __HW_ADC_H__
+#define __HW_ADC_H__
+
+#define ADC_O_SSFIFO3           0x000000A8
+
+#endif /* __HW_ADC_H__ */
@@ -0,0 +1,28 @@
+/*******************************************************************************
+ *
+ * hw_ints.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's inc/hw_ints.h.
+ * Only the parts used by this project are provided.
+ *
+ ******************************************************************************/
+
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+
+#define FAULT_SYSTICK           15
+#define INT_GPIOB               17
+#define INT_GPIOC               18
+#define INT_ADC0SS3             33
+#define INT_TIMER0A             35
+
+#endif /* __HW_INTS_H__ */
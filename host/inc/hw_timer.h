@@ -0,0 +1,27 @@
+/*******************************************************************************
+ *
+ * hw_timer.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's inc/hw_timer.h.
+ * Only the parts used by this project are provided.
+ *
+ ******************************************************************************/
+
+#ifndef __HW_TIMER_H__
+#define __HW_TIMER_H__
+
+#define TIMER_O_CFG             0x00000000
+#define TIMER_O_TAMR            0x00000004
+
+#define TIMER_TAMR_TAMIE        0x00000020
+
+#endif /* __HW_TIMER_H__ */
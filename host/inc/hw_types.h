@@ -0,0 +1,33 @@
+/*******************************************************************************
+ *
+ * hw_types.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's inc/hw_types.h.
+ * Only the parts used by this project are provided.
+ *
+ ******************************************************************************/
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Register accesses go to a small register file kept by the host HAL rather
+ * than to the (non-existent) peripherals.
+ */
+volatile uint32_t* hal_register(uint32_t t_address);
+
+#define HWREG(x) (*hal_register(x))
+
+#endif /* __HW_TYPES_H__ */
@@ -0,0 +1,30 @@
+/*******************************************************************************
+ *
+ * tm4c123gh6pm.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's inc/tm4c123gh6pm.h.
+ * Only the parts used by this project are provided. The functions are
+ * implemented by the host HAL (hal.c).
+ *
+ ******************************************************************************/
+
+#ifndef __TM4C123GH6PM_H__
+#define __TM4C123GH6PM_H__
+
+#include <stdint.h>
+
+extern volatile uint32_t GPIO_PORTD_LOCK_R;
+extern volatile uint32_t GPIO_PORTD_CR_R;
+extern volatile uint32_t GPIO_PORTF_LOCK_R;
+extern volatile uint32_t GPIO_PORTF_CR_R;
+
+#endif /* __TM4C123GH6PM_H__ */
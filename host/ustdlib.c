@@ -0,0 +1,58 @@
+/*******************************************************************************
+ *
+ * ustdlib.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for the formatting functions of TivaWare's ustdlib.c.
+ * The project's ustdlib.c reads %d and %u arguments as unsigned long, which
+ * is 32 bits on the target but 64 bits on a 64-bit host, so every negative
+ * value would come out as a huge unsigned number. These pass the format on
+ * to the C library instead, which reads them as int and unsigned int like
+ * the target does. The firmware only uses %c, %d, %s, %u and %%, with field
+ * widths, which both format the same way.
+ *
+ ******************************************************************************/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "utils/ustdlib.h"
+
+int uvsnprintf(char * restrict s, size_t n, const char * restrict format, va_list arg)
+{
+    return vsnprintf(s, n, format, arg);
+}
+
+int usnprintf(char * restrict s, size_t n, const char * restrict format, ...)
+{
+    va_list arg;
+    int ret;
+
+    va_start(arg, format);
+    ret = uvsnprintf(s, n, format, arg);
+    va_end(arg);
+
+    return ret;
+}
+
+int usprintf(char * restrict s, const char * restrict format, ...)
+{
+    va_list arg;
+    int ret;
+
+    // like ustdlib.c, usprintf doesn't check the size of the buffer
+    va_start(arg, format);
+    ret = uvsnprintf(s, 0xffff, format, arg);
+    va_end(arg);
+
+    return ret;
+}
@@ -0,0 +1,31 @@
+/*******************************************************************************
+ *
+ * ustdlib.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * Host build stand-in for TivaWare's utils/ustdlib.h.
+ * Only the formatting functions used by this project are provided. They are
+ * implemented by host/ustdlib.c, so the ustdlib.c in the project root is left
+ * out of the host build.
+ *
+ ******************************************************************************/
+
+#ifndef __USTDLIB_H__
+#define __USTDLIB_H__
+
+#include <stdarg.h>
+#include <stddef.h>
+
+extern int usnprintf(char * restrict s, size_t n, const char * restrict format, ...);
+extern int usprintf(char * restrict s, const char * restrict format, ...);
+extern int uvsnprintf(char * restrict s, size_t n, const char * restrict format, va_list arg);
+
+#endif /* __USTDLIB_H__ */
@@ -134,8 +134,17 @@ void input_update(KernelTask* t_task)
         }
     }
 #else
+    // calibrate the rig: landed when SW1 goes down, and full height (flown
+    // there by hand) when it goes up. both are stored in the EEPROM.
     if (sw_changed) {
-        alt_calibrate();
+        if (sw_state == SLIDER_DOWN)
+        {
+            alt_calibrate();
+        }
+        else
+        {
+            alt_calibrate_full_height();
+        }
     }
 #endif
 
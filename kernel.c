@@ -16,22 +16,30 @@
  ******************************************************************************/
 
 #include <stdint.h>
-#include <stdlib.h>
 #include <stdbool.h>
-#include <limits.h>
+#include <string.h>
 
+#include "inc/hw_memmap.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/systick.h"
+#include "driverlib/timer.h"
 
+#include "config.h"
 #include "kernel.h"
 #include "mutex.h"
 #include "utils.h"
 
+#if CONFIG_HOST_BUILD
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+// a task's ready flag is a bit in a uint32_t
+KERNEL_STATIC_ASSERT(KERNEL_MAX_TASKS <= 32, kernel_max_tasks_too_big);
 
-/**
- * The maximum amount of tasks that can be scheduled.
- */
-static const uint8_t MAX_TASKS = 16;
 
 /**
  * The total number of tasks stored in the g_tasks array.
@@ -39,10 +47,54 @@ static const uint8_t MAX_TASKS = 16;
 static uint8_t g_task_total;
 
 /**
- * The array of tasks (to be allocated in kernel_init)
+ * The task table given to kernel_init.
  */
 static KernelTask* g_tasks;
 
+/**
+ * The timing statistics for each task. These are kept separately from the
+ * task table so that the table stays small to write out.
+ */
+static KernelTaskStats g_task_stats[KERNEL_MAX_TASKS];
+
+/**
+ * A binary min-heap of indices into g_tasks, ordered by the tick count at
+ * which each task is next due.
+ * Tasks that run every tick or on an event are not stored in the queue.
+ */
+static uint8_t g_task_queue[KERNEL_MAX_TASKS];
+
+/**
+ * The number of task indices stored in the g_task_queue heap.
+ */
+static uint8_t g_queue_size;
+
+/**
+ * A bit mask of the tasks that must run every time the tick count changes.
+ */
+static uint32_t g_always_mask;
+
+/**
+ * A bit mask of the tasks released by each event.
+ */
+static uint32_t g_event_masks[KERNEL_EVENT_COUNT];
+
+/**
+ * The deferred work queue of events posted by ISRs. This has a single
+ * producer (the ISRs, which can't preempt each other) and a single consumer
+ * (kernel_run). Only the producer writes the head and only the consumer
+ * writes the tail, so no locking is needed. The size must be a power of 2.
+ */
+#define EVENT_QUEUE_SIZE 16
+static volatile uint8_t g_event_queue[EVENT_QUEUE_SIZE];
+static volatile uint8_t g_event_head;
+static volatile uint8_t g_event_tail;
+
+/**
+ * The number of events that were dropped because the queue was full.
+ */
+static volatile uint32_t g_event_overflows;
+
 /**
  * Stores the number of times the SysTickIntHandler has been called when
  * kernel_run was last called.
@@ -56,32 +108,373 @@ static volatile uint32_t g_systick_count;
 
 static Mutex g_systick_count_mutex;
 
+/**
+ * The number of processor cycles between SysTick interrupts.
+ */
+static uint32_t g_systick_period;
+
+#if KERNEL_TICKLESS
+/**
+ * In tickless mode Timer 0 (both halves concatenated) counts up at the system
+ * clock and is never reset. Its value is used as the tick count and its match
+ * interrupt wakes the processor when the next task is due.
+ */
+static const uint32_t KERNEL_TIMER_PERIPH = SYSCTL_PERIPH_TIMER0;
+static const uint32_t KERNEL_TIMER_BASE = TIMER0_BASE;
+#endif
+
+/**
+ * The Cortex-M4 debug registers used to enable and read the DWT cycle counter.
+ */
+static const uint32_t DWT_CTRL = 0xE0001000;
+static const uint32_t DWT_CTRL_CYCCNTENA = 0x00000001;
+static const uint32_t DWT_CYCCNT = 0xE0001004;
+static const uint32_t DEMCR = 0xE000EDFC;
+static const uint32_t DEMCR_TRCENA = 0x01000000;
+
+/**
+ * The clock source used to time tasks.
+ */
+static const KernelClock* g_clock;
+
+/**
+ * The number of cycles the virtual clock has been advanced by.
+ */
+static volatile uint32_t g_virtual_cycles;
+
+/**
+ * The number of clock cycles in one microsecond and in one kernel tick.
+ */
+static uint32_t g_cycles_per_micro;
+static uint32_t g_cycles_per_tick;
+
+/**
+ * The number of cycles spent running passes (tasks and scheduler, but not
+ * the SysTick interrupts taken during them) and the cycle count when this
+ * measurement window started.
+ */
+static uint32_t g_busy_cycles;
+static uint32_t g_window_start;
+
+/**
+ * The number of cycles spent in the SysTick interrupt since kernel_init, and
+ * that count when this measurement window started. Only the periodic kernel
+ * takes the interrupt.
+ */
+static volatile uint32_t g_tick_cycles;
+static uint32_t g_window_tick_cycles;
+
+/**
+ * The cycles the processor takes to enter and leave an interrupt (stacking
+ * and unstacking the registers), which the SysTick interrupt can't time
+ * itself.
+ */
+static const uint32_t KERNEL_INT_ENTRY_EXIT_CYCLES = 24;
+
+/**
+ * The scheduler overhead (in cycles) of the latest pass and the worst pass
+ * since kernel_get_overhead_cycles was last called.
+ */
+static uint32_t g_overhead_cycles;
+static uint32_t g_overhead_cycles_max;
+
+/**
+ * The longest pass (in cycles) and the most tasks run in one pass since
+ * kernel_get_pass_peak was last called.
+ */
+static uint32_t g_pass_cycles_max;
+static uint8_t g_pass_tasks_max;
+
+/**
+ * Is true while the kernel is recovering from an overrun. Low priority tasks
+ * are shed until a pass runs with every task inside its budget.
+ */
+static bool g_shedding;
+
+/**
+ * The total number of task releases shed and passes that overran.
+ */
+static uint32_t g_shed_total;
+static uint32_t g_overrun_total;
+
+/**
+ * The most releases in a row that a task can shed. This decimates low
+ * priority tasks during a long overload rather than stopping them.
+ */
+static const uint8_t KERNEL_SHED_LIMIT = 4;
+
 /**
  * The frequency that the kernel runs at.
  */
 static uint32_t g_kernel_frequency;
 
 /**
- * Is true when memory allocation was successful.
+ * Is true when the task table was accepted by kernel_init.
  */
 static bool g_init_ok = false;
 
 /**
- * The SysTick event handler. Simply increments a global static variable.
+ * The SysTick event handler. Increments a global static variable and keeps
+ * track of how long it took, since it runs on every kernel tick.
  */
 void kernel_systick_int_handler(void)
 {
+    uint32_t start_cycles = kernel_get_cycle_count();
+
     mutex_lock(g_systick_count_mutex);
     g_systick_count++;
     mutex_unlock(g_systick_count_mutex);
+
+    g_tick_cycles += kernel_get_cycle_count() - start_cycles + KERNEL_INT_ENTRY_EXIT_CYCLES;
+}
+
+/**
+ * Converts clock cycles into microseconds.
+ */
+uint32_t kernel_convert_cycles_to_microseconds(uint32_t t_cycles)
+{
+    return t_cycles / g_cycles_per_micro;
+}
+
+/**
+ * The timer match interrupt handler. This only exists to wake the processor,
+ * the tasks themselves are run from kernel_run.
+ */
+void kernel_timer_int_handler(void)
+{
+#if KERNEL_TICKLESS
+    TimerIntClear(KERNEL_TIMER_BASE, TIMER_TIMA_MATCH);
+#endif
+}
+
+/**
+ * Returns the number of processor cycles since the kernel was initialised.
+ * In periodic mode this combines the SysTick count with the current value of
+ * the SysTick counter, in tickless mode it is the free-running timer.
+ * This wraps around every 2^32 cycles (about 107 seconds at 40 MHz).
+ */
+uint32_t kernel_tick_clock_read(void)
+{
+#if KERNEL_TICKLESS
+    return TimerValueGet(KERNEL_TIMER_BASE, TIMER_A);
+#else
+    uint32_t count;
+    uint32_t value;
+
+    // re-read if the SysTick interrupt happened part way through
+    do
+    {
+        count = g_systick_count;
+        value = SysTickValueGet();
+    } while (count != g_systick_count);
+
+    return count * g_systick_period + (g_systick_period - 1 - value);
+#endif
+}
+
+/**
+ * Enables the DWT cycle counter.
+ */
+void kernel_dwt_clock_init(void)
+{
+    HWREG(DEMCR) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
+
+/**
+ * Returns the value of the DWT cycle counter.
+ */
+uint32_t kernel_dwt_clock_read(void)
+{
+    return HWREG(DWT_CYCCNT);
+}
+
+/**
+ * Returns the number of cycles the virtual clock has been advanced by.
+ */
+uint32_t kernel_virtual_clock_read(void)
+{
+    return g_virtual_cycles;
+}
+
+const KernelClock KERNEL_CLOCK_TICK = { NULL, kernel_tick_clock_read };
+const KernelClock KERNEL_CLOCK_DWT = { kernel_dwt_clock_init, kernel_dwt_clock_read };
+const KernelClock KERNEL_CLOCK_VIRTUAL = { NULL, kernel_virtual_clock_read };
+
+void kernel_set_clock(const KernelClock* t_clock)
+{
+    g_clock = t_clock;
+    if (g_clock->init != NULL)
+    {
+        g_clock->init();
+    }
+}
+
+void kernel_clock_advance(uint32_t t_cycles)
+{
+    g_virtual_cycles += t_cycles;
+}
+
+uint32_t kernel_get_cycle_count(void)
+{
+    return g_clock->read();
+}
+
+/**
+ * Returns true if the tick count t_now has reached t_due. This is safe
+ * when the tick count overflows.
+ */
+static bool kernel_is_due(uint32_t t_due, uint32_t t_now)
+{
+    return (int32_t)(t_now - t_due) >= 0;
+}
+
+/**
+ * Returns true if task a is due before task b.
+ */
+static bool kernel_queue_before(uint8_t t_a, uint8_t t_b)
+{
+    return (int32_t)(g_tasks[t_a].due_count - g_tasks[t_b].due_count) < 0;
+}
+
+/**
+ * Adds a task index to the queue (sifting it up to its place in the heap).
+ */
+void kernel_queue_push(uint8_t t_index)
+{
+    uint8_t child = g_queue_size++;
+
+    while (child > 0)
+    {
+        uint8_t parent = (child - 1) / 2;
+        if (!kernel_queue_before(t_index, g_task_queue[parent]))
+        {
+            break;
+        }
+        g_task_queue[child] = g_task_queue[parent];
+        child = parent;
+    }
+
+    g_task_queue[child] = t_index;
+}
+
+/**
+ * Removes and returns the task index that is due soonest (sifting the last
+ * element down to fill the gap).
+ */
+uint8_t kernel_queue_pop(void)
+{
+    uint8_t top = g_task_queue[0];
+    uint8_t last = g_task_queue[--g_queue_size];
+    uint8_t parent = 0;
+
+    while (true)
+    {
+        uint8_t child = 2 * parent + 1;
+        if (child >= g_queue_size)
+        {
+            break;
+        }
+        if (child + 1 < g_queue_size && kernel_queue_before(g_task_queue[child + 1], g_task_queue[child]))
+        {
+            child++;
+        }
+        if (!kernel_queue_before(g_task_queue[child], last))
+        {
+            break;
+        }
+        g_task_queue[parent] = g_task_queue[child];
+        parent = child;
+    }
+
+    if (g_queue_size > 0)
+    {
+        g_task_queue[parent] = last;
+    }
+
+    return top;
+}
+
+/**
+ * Returns the index of the lowest set bit in a non-zero mask.
+ */
+static uint8_t kernel_lowest_bit(uint32_t t_mask)
+{
+#if defined(__TI_COMPILER_VERSION__)
+    return 31 - __clz(t_mask & -t_mask);
+#else
+    return __builtin_ctz(t_mask);
+#endif
+}
+
+/**
+ * Returns the index of the highest set bit in a non-zero mask.
+ */
+static uint8_t kernel_highest_bit(uint32_t t_mask)
+{
+#if defined(__TI_COMPILER_VERSION__)
+    return 31 - __clz(t_mask);
+#else
+    return 31 - __builtin_clz(t_mask);
+#endif
+}
+
+/**
+ * Empties a histogram.
+ */
+void kernel_histogram_reset(KernelHistogram* t_histogram)
+{
+    memset(t_histogram, 0, sizeof(KernelHistogram));
 }
 
 /**
- * Converts kernel ticks into microseconds.
+ * Adds a sample to a histogram.
  */
-uint32_t kernel_convert_ticks_to_microseconds(uint32_t t_ticks)
+void kernel_histogram_add(KernelHistogram* t_histogram, int32_t t_value)
 {
-    return t_ticks * 1000000.0f / g_kernel_frequency;
+    uint8_t bucket = 0;
+    if (t_value > 0)
+    {
+        bucket = min(kernel_highest_bit(t_value) + 1, KERNEL_HISTOGRAM_BUCKETS - 1);
+    }
+    t_histogram->buckets[bucket]++;
+
+    if (t_histogram->count == 0 || t_value < t_histogram->min)
+    {
+        t_histogram->min = t_value;
+    }
+    if (t_histogram->count == 0 || t_value > t_histogram->max)
+    {
+        t_histogram->max = t_value;
+    }
+    t_histogram->count++;
+}
+
+int32_t kernel_histogram_percentile(const KernelHistogram* t_histogram, uint8_t t_percent)
+{
+    if (t_histogram->count == 0)
+    {
+        return 0;
+    }
+
+    // the number of samples that must be at or below the percentile
+    uint32_t target = ((uint64_t)t_histogram->count * t_percent + 99) / 100;
+    uint32_t total = 0;
+    uint8_t bucket;
+
+    for (bucket = 0; bucket < KERNEL_HISTOGRAM_BUCKETS - 1; bucket++)
+    {
+        total += t_histogram->buckets[bucket];
+        if (total >= target)
+        {
+            break;
+        }
+    }
+
+    // the top of the bucket (bucket 0 holds values of 0 or less)
+    int32_t upper = bucket == 0 ? 0 : (int32_t)((1ul << bucket) - 1);
+    return min(upper, t_histogram->max);
 }
 
 /**
@@ -93,7 +486,8 @@ void kernel_init_systick(void)
     //
     // Set up the period for the SysTick timer.  The SysTick timer period is
     // set as a function of the system clock.
-    SysTickPeriodSet(SysCtlClockGet() / g_kernel_frequency);
+    g_systick_period = SysCtlClockGet() / g_kernel_frequency;
+    SysTickPeriodSet(g_systick_period);
     //
     // Register the interrupt handler
     SysTickIntRegister(kernel_systick_int_handler);
@@ -103,125 +497,406 @@ void kernel_init_systick(void)
     SysTickEnable();
 }
 
-void kernel_init(uint32_t t_frequency)
+/**
+ * Initialises the free-running timer used in tickless mode.
+ */
+void kernel_init_timer(void)
 {
-    g_task_total = 0;
-    g_systick_count = 0;
-    g_last_count = 0;
-    g_kernel_frequency = t_frequency;
+#if KERNEL_TICKLESS
+    SysCtlPeripheralEnable(KERNEL_TIMER_PERIPH);
+    while (!SysCtlPeripheralReady(KERNEL_TIMER_PERIPH))
+    {
+        continue;
+    }
 
-    // allocate the memory for the arrays
-    g_tasks = malloc(sizeof(KernelTask) * MAX_TASKS);
+    // a full width timer counting up from 0 and wrapping at 2^32
+    TimerConfigure(KERNEL_TIMER_BASE, TIMER_CFG_PERIODIC_UP);
+    TimerLoadSet(KERNEL_TIMER_BASE, TIMER_A, UINT32_MAX);
 
-    // set g_init_ok if memory was allocated
-    g_init_ok = g_tasks != NULL;
+    // driverlib has no function for enabling the match interrupt
+    HWREG(KERNEL_TIMER_BASE + TIMER_O_TAMR) |= TIMER_TAMR_TAMIE;
 
-    kernel_init_systick();
+    TimerIntRegister(KERNEL_TIMER_BASE, TIMER_A, kernel_timer_int_handler);
+    TimerIntEnable(KERNEL_TIMER_BASE, TIMER_TIMA_MATCH);
+    TimerEnable(KERNEL_TIMER_BASE, TIMER_A);
+#endif
+}
+
+/**
+ * Puts the processor to sleep until the next queued task is due (or any
+ * other interrupt occurs). Returns straight away if a task must run every
+ * pass or the next task is already due.
+ */
+void kernel_sleep(void)
+{
+#if KERNEL_TICKLESS
+    if (g_always_mask != 0 || g_queue_size == 0)
+    {
+        return;
+    }
+
+    // interrupts are masked so that one can't sneak in between the check and
+    // the WFI. a pending interrupt still wakes the processor while masked.
+    IntMasterDisable();
+
+    uint32_t due_count = g_tasks[g_task_queue[0]].due_count;
+    TimerMatchSet(KERNEL_TIMER_BASE, TIMER_A, due_count);
+
+    // an ISR may have posted an event since the pass started
+    if (g_event_head == g_event_tail && !kernel_is_due(due_count, kernel_tick_clock_read()))
+    {
+        SysCtlSleep();
+    }
+
+    IntMasterEnable();
+#endif
 }
 
 /**
- * The compare function to be plugged into stdlib's qsort.
+ * Staggers the first release of each periodic task so that they don't all
+ * come due on the same tick. The offsets are spread evenly across the
+ * shortest period, so two tasks whose periods are multiples of one another
+ * never come due on the same tick.
  */
-int kernel_task_compare(const void * t_task_a, const void * t_task_b)
+void kernel_assign_phases(void)
 {
-    const KernelTask* task_a = (const KernelTask *)t_task_a;
-    const KernelTask* task_b = (const KernelTask *)t_task_b;
-    return (int)task_a->priority - (int)task_b->priority;
+    uint8_t i;
+    uint8_t periodic_total = 0;
+    uint32_t shortest_period = UINT32_MAX;
+
+    for (i = 0; i < g_task_total; i++)
+    {
+        if (g_tasks[i].event == KERNEL_EVENT_NONE && g_tasks[i].period_ticks != 0)
+        {
+            periodic_total++;
+            shortest_period = min(shortest_period, g_tasks[i].period_ticks);
+        }
+    }
+
+    // the highest priority task keeps a phase of 0
+    uint8_t slot = 0;
+    for (i = 0; i < g_task_total; i++)
+    {
+        if (g_tasks[i].event == KERNEL_EVENT_NONE && g_tasks[i].period_ticks != 0)
+        {
+            g_tasks[i].due_count = g_tasks[i].period_ticks + (shortest_period / periodic_total) * slot;
+            slot++;
+        }
+    }
 }
 
-void kernel_add_task(char* t_name, void* t_func_ptr, uint16_t t_frequency, uint8_t t_priority)
+/**
+ * Stops the program when kernel_init is given a table that it can't run,
+ * rather than carry on with no tasks and no sign of why.
+ */
+static void kernel_reject_tasks(uint8_t t_task_count)
 {
-    // only add tasks if enough memory has been allocated and everything is ok
-    if (g_task_total < MAX_TASKS && g_init_ok)
+#if CONFIG_HOST_BUILD
+    fprintf(stderr, "kernel: task table rejected (%u tasks, at most %u, must be in priority order)\n",
+            t_task_count, KERNEL_MAX_TASKS);
+    abort();
+#else
+    // this is before the rotors are started, so they stay off. a debugger
+    // paused here shows the table in t_task_count and g_tasks
+    IntMasterDisable();
+    while (true)
     {
-        KernelTask task = (KernelTask){
-            t_name,
-            t_func_ptr,
-            t_frequency,
-            t_priority,
-            0,
-            0
-        };
+    }
+#endif
+}
+
+void kernel_init(KernelTask* t_tasks, uint8_t t_task_count)
+{
+    uint8_t i;
 
-        // if the frequency is too high for the kernel
-        // to support, make the task run every time.
-        if (task.frequency > g_kernel_frequency)
+    g_task_total = 0;
+    g_queue_size = 0;
+    g_always_mask = 0;
+    g_event_head = 0;
+    g_event_tail = 0;
+    g_event_overflows = 0;
+    memset(g_event_masks, 0, sizeof(g_event_masks));
+    g_systick_count = 0;
+    g_last_count = 0;
+    g_overhead_cycles = 0;
+    g_overhead_cycles_max = 0;
+    g_pass_cycles_max = 0;
+    g_pass_tasks_max = 0;
+    g_busy_cycles = 0;
+    g_tick_cycles = 0;
+    g_window_tick_cycles = 0;
+    g_shedding = false;
+    g_shed_total = 0;
+    g_overrun_total = 0;
+
+    g_kernel_frequency = KERNEL_TICK_FREQUENCY;
+    g_cycles_per_micro = SysCtlClockGet() / 1000000;
+    g_cycles_per_tick = SysCtlClockGet() / g_kernel_frequency;
+
+    // the virtual clock is the only one that works off the board
+#if CONFIG_HOST_BUILD
+    kernel_set_clock(&KERNEL_CLOCK_VIRTUAL);
+#else
+    kernel_set_clock(&KERNEL_CLOCK_DWT);
+#endif
+    g_window_start = kernel_get_cycle_count();
+
+    // the table must fit in the ready bit masks and be in priority order,
+    // because the bit masks also give the order the tasks run in
+    g_init_ok = t_task_count <= KERNEL_MAX_TASKS;
+    for (i = 1; i < t_task_count && g_init_ok; i++)
+    {
+        g_init_ok = t_tasks[i - 1].priority <= t_tasks[i].priority;
+    }
+
+    g_tasks = t_tasks;
+    if (!g_init_ok)
+    {
+        kernel_reject_tasks(t_task_count);
+    }
+    g_task_total = t_task_count;
+
+#if KERNEL_PHASE_OFFSETS
+    kernel_assign_phases();
+#endif
+
+    // sort the tasks into those that are released by events, those that
+    // run every tick and those that wait in the queue
+    for (i = 0; i < g_task_total; i++)
+    {
+        kernel_reset_task_stats(i);
+        g_tasks[i].has_run = false;
+
+        if (g_tasks[i].event != KERNEL_EVENT_NONE)
         {
-            task.frequency = 0;
+            g_event_masks[g_tasks[i].event] |= 1ul << i;
         }
+        else if (g_tasks[i].period_ticks == 0)
+        {
+            g_always_mask |= 1ul << i;
+        }
+        else
+        {
+            kernel_queue_push(i);
+        }
+    }
+
+#if KERNEL_TICKLESS
+    kernel_init_timer();
+#else
+    kernel_init_systick();
+#endif
+}
+
+void kernel_post_event(KernelEvent t_event)
+{
+    // don't bother queueing events that nothing is waiting for
+    if (g_event_masks[t_event] == 0)
+    {
+        return;
+    }
 
-        g_tasks[g_task_total] = task;
-        g_task_total++;
+    uint8_t head = g_event_head;
+    if ((uint8_t)(head - g_event_tail) >= EVENT_QUEUE_SIZE)
+    {
+        g_event_overflows++;
+        return;
     }
+
+    // the event must be written before the head is published
+    g_event_queue[head & (EVENT_QUEUE_SIZE - 1)] = t_event;
+    g_event_head = head + 1;
 }
 
-void kernel_prioritise(void)
+uint32_t kernel_get_event_overflows(void)
 {
-    qsort(g_tasks, g_task_total, sizeof(KernelTask), kernel_task_compare);
+    return g_event_overflows;
+}
+
+/**
+ * Returns true if the task can skip this release to help the kernel recover
+ * from an overrun.
+ */
+static bool kernel_can_shed(const KernelTask* t_task)
+{
+    return t_task->priority >= KERNEL_SHED_PRIORITY
+            && t_task->period_ticks != 0
+            && t_task->shed_streak < KERNEL_SHED_LIMIT;
+}
+
+/**
+ * Queues up the next release of a periodic task. The release is counted on
+ * from when the task was due rather than when it ran, so a late pass doesn't
+ * shift the task's phase. Any releases that have already been missed are
+ * skipped rather than run back to back.
+ */
+static void kernel_queue_next_release(uint8_t t_index, uint32_t t_now)
+{
+    KernelTask* task = &g_tasks[t_index];
+
+    task->due_count += task->period_ticks;
+    if (kernel_is_due(task->due_count, t_now))
+    {
+        task->due_count += ((t_now - task->due_count) / task->period_ticks + 1) * task->period_ticks;
+    }
+
+    kernel_queue_push(t_index);
+}
+
+/**
+ * Takes all of the posted events off the queue and returns the bit mask of
+ * the tasks that they release.
+ */
+uint32_t kernel_take_events(void)
+{
+    uint32_t ready = 0;
+    uint8_t tail = g_event_tail;
+    uint8_t head = g_event_head;
+
+    while (tail != head)
+    {
+        ready |= g_event_masks[g_event_queue[tail & (EVENT_QUEUE_SIZE - 1)]];
+        tail++;
+    }
+
+    // the events must be read before the tail is published
+    g_event_tail = tail;
+
+    return ready;
 }
 
 void kernel_run(void)
 {
     if (g_task_total > 0)
     {
-        mutex_wait(g_systick_count_mutex);
-        uint32_t this_count = g_systick_count;
-        if (g_last_count != this_count)
+        uint32_t this_count = kernel_get_systick_count();
+        bool events_pending = g_event_head != g_event_tail;
+        if (g_last_count != this_count || events_pending)
         {
-            // iterate through each task and see if it needs to be
-            // run.
-            uint8_t i;
-            for (i = 0; i < g_task_total; i++)
+            uint32_t pass_start = kernel_get_cycle_count();
+            uint32_t pass_tick_cycles = g_tick_cycles;
+            uint32_t task_cycles = 0;
+            uint8_t task_count = 0;
+            bool overrun = false;
+
+            // tasks released by an event run on this pass regardless of the tick
+            uint32_t ready = events_pending ? kernel_take_events() : 0;
+
+            // the "always" tasks run once per tick
+            if (g_last_count != this_count)
+            {
+                ready |= g_always_mask;
+            }
+
+            // take every task that has come due off the front of the queue.
+            // the tasks array is sorted by priority, so the bit mask
+            // also gives us the order to run them in.
+            while (g_queue_size > 0 && kernel_is_due(g_tasks[g_task_queue[0]].due_count, this_count))
             {
-                KernelTask task = g_tasks[i];
-                uint32_t count_delta;
+                ready |= 1ul << kernel_queue_pop();
+            }
 
-                // fix the possible overflow
-                count_delta = this_count - task.int_count;
-                if (this_count < task.int_count)
-                {
-                    count_delta = UINT_MAX - task.int_count + this_count;
-                }
+            while (ready != 0)
+            {
+                uint8_t i = kernel_lowest_bit(ready);
+                KernelTask* task = &g_tasks[i];
+                ready &= ready - 1;
 
-                // check if the task must be run
-                if (task.frequency == 0 || (((float)count_delta / g_kernel_frequency) > (1.0f / task.frequency)))
+                // while recovering from an overrun the low priority tasks
+                // give up their release so that the rest keep their rates
+                if (g_shedding && kernel_can_shed(task))
                 {
-                    mutex_wait(g_systick_count_mutex);
-                    uint32_t start_count = g_systick_count;
+                    task->shed_count++;
+                    task->shed_streak++;
+                    g_shed_total++;
 
-                    g_tasks[i].period_micros = kernel_convert_ticks_to_microseconds(count_delta - 1);
+                    kernel_queue_next_release(i, this_count);
+                    continue;
+                }
+                task->shed_streak = 0;
 
-                    // execute the task
-                    ((void(*)(KernelTask*))(task.function))(&task);
+                uint32_t start_cycles = kernel_get_cycle_count();
 
-                    mutex_wait(g_systick_count_mutex);
-                    uint32_t end_count = g_systick_count;
+                task->period_cycles = start_cycles - task->start_cycles;
+                task->period_micros = kernel_convert_cycles_to_microseconds(task->period_cycles);
+                task->start_cycles = start_cycles;
 
-                    uint32_t duration_count = end_count - start_count;
-                    if (end_count < start_count)
-                    {
-                        duration_count = UINT_MAX - start_count + end_count;
-                    }
+                // execute the task
+                ((void(*)(KernelTask*))(task->function))(task);
 
-                    // we keep track of the time taken to perform a task
-                    g_tasks[i].duration_micros = kernel_convert_ticks_to_microseconds(duration_count);
+                // we keep track of the time taken to perform a task
+                task->duration_cycles = kernel_get_cycle_count() - start_cycles;
+                task->duration_micros = kernel_convert_cycles_to_microseconds(task->duration_cycles);
+                task_cycles += task->duration_cycles;
+                task_count++;
+                kernel_histogram_add(&g_task_stats[i].duration, task->duration_cycles);
 
-                    // update the last time it was run
-                    g_tasks[i].int_count = this_count;
+                // start shedding straight away if the task ran over its budget
+                if (task->duration_cycles > task->budget_cycles)
+                {
+                    task->overrun_count++;
+                    overrun = true;
+                    g_shedding = true;
+                }
 
+                // and how late (or early) it was released. the first run has
+                // no previous start to measure the period from.
+                if (task->period_ticks != 0 && task->has_run)
+                {
+                    int32_t nominal_cycles = task->period_ticks * g_cycles_per_tick;
+                    kernel_histogram_add(&g_task_stats[i].jitter, (int32_t)task->period_cycles - nominal_cycles);
                 }
 
+                // update the last time it was run and queue up the next run
+                task->int_count = this_count;
+                task->has_run = true;
+                if (task->period_ticks != 0)
+                {
+                    kernel_queue_next_release(i, this_count);
+                }
             }
 
             g_last_count = this_count;
+
+            // keep shedding until a pass runs without an overrun
+            if (overrun)
+            {
+                g_overrun_total++;
+            }
+            g_shedding = overrun;
+
+            // keep track of how long the scheduler itself took
+            uint32_t pass_cycles = kernel_get_cycle_count() - pass_start;
+            g_busy_cycles += pass_cycles - (g_tick_cycles - pass_tick_cycles);
+            g_overhead_cycles = pass_cycles - task_cycles;
+            if (g_overhead_cycles > g_overhead_cycles_max)
+            {
+                g_overhead_cycles_max = g_overhead_cycles;
+            }
+
+            // and the worst pass, which is where the tasks pile up
+            g_pass_cycles_max = max(g_pass_cycles_max, pass_cycles);
+            g_pass_tasks_max = max(g_pass_tasks_max, task_count);
         }
+
+        kernel_sleep();
     }
 }
 
 uint32_t kernel_get_systick_count(void)
 {
+#if KERNEL_TICKLESS
+    return kernel_tick_clock_read();
+#else
     mutex_wait(g_systick_count_mutex);
     return g_systick_count;
+#endif
+}
+
+uint32_t kernel_get_shed_count(uint32_t* t_overruns)
+{
+    *t_overruns = g_overrun_total;
+    return g_shed_total;
 }
 
 uint32_t kernel_get_frequency(void)
@@ -229,6 +904,70 @@ uint32_t kernel_get_frequency(void)
     return g_kernel_frequency;
 }
 
+uint32_t kernel_get_overhead_cycles(uint32_t* t_max)
+{
+    *t_max = g_overhead_cycles_max;
+    g_overhead_cycles_max = 0;
+    return g_overhead_cycles;
+}
+
+uint32_t kernel_get_pass_peak(uint8_t* t_max_tasks)
+{
+    uint32_t max_cycles = g_pass_cycles_max;
+    *t_max_tasks = g_pass_tasks_max;
+
+    g_pass_cycles_max = 0;
+    g_pass_tasks_max = 0;
+
+    return max_cycles;
+}
+
+void kernel_get_load(uint16_t* t_busy_permille, uint16_t* t_tick_permille, uint16_t* t_idle_permille)
+{
+    uint32_t now = kernel_get_cycle_count();
+    uint32_t tick_now = g_tick_cycles;
+    uint32_t window = now - g_window_start;
+    uint32_t tick_cycles = tick_now - g_window_tick_cycles;
+
+    // whatever wasn't spent in a pass or the SysTick interrupt was idle, be
+    // it asleep or spinning between passes
+    if (window != 0 && g_busy_cycles + tick_cycles <= window)
+    {
+        *t_busy_permille = ((uint64_t)g_busy_cycles * 1000) / window;
+        *t_tick_permille = ((uint64_t)tick_cycles * 1000) / window;
+        *t_idle_permille = 1000 - *t_busy_permille - *t_tick_permille;
+    }
+    else
+    {
+        *t_busy_permille = 0;
+        *t_tick_permille = 0;
+        *t_idle_permille = 0;
+    }
+
+    // start a new window
+    g_busy_cycles = 0;
+    g_window_tick_cycles = tick_now;
+    g_window_start = now;
+}
+
+const KernelTaskStats* kernel_get_task_stats(uint8_t t_index)
+{
+    if (t_index >= g_task_total)
+    {
+        return NULL;
+    }
+    return &g_task_stats[t_index];
+}
+
+void kernel_reset_task_stats(uint8_t t_index)
+{
+    if (t_index < KERNEL_MAX_TASKS)
+    {
+        kernel_histogram_reset(&g_task_stats[t_index].duration);
+        kernel_histogram_reset(&g_task_stats[t_index].jitter);
+    }
+}
+
 bool kernel_ready(void)
 {
     return g_init_ok;
@@ -245,3 +984,6 @@ void kernel_saturation_task(KernelTask* t_task)
     utils_wait_for_seconds(1);
 }
 
+void kernel_benchmark_task(KernelTask* t_task)
+{
+}
@@ -21,8 +21,73 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "clock.h"
+#include "config.h"
+
 #define Task(name) void name(KernelTask* this)
 
+/**
+ * The number of buckets in each task histogram. Bucket 0 counts values of 0
+ * or less and bucket n counts values from 2^(n-1) up to 2^n - 1, so 32
+ * buckets cover every positive int32_t. The samples are in clock cycles,
+ * and a 1 Hz task's jitter can be tens of millions of them.
+ */
+#define KERNEL_HISTOGRAM_BUCKETS 32
+
+/**
+ * Tasks with a priority number at or above this are shed (skip a release)
+ * while the kernel is recovering from a pass in which a task ran over its
+ * budget. Only periodic tasks are ever shed.
+ */
+#define KERNEL_SHED_PRIORITY 100
+
+/**
+ * The maximum amount of tasks that can be scheduled.
+ * This must not exceed the number of bits in a uint32_t as tasks are
+ * flagged as ready using a bit mask. The kernel benchmark raises it to
+ * measure bigger tables.
+ */
+#ifndef KERNEL_MAX_TASKS
+#define KERNEL_MAX_TASKS 16
+#endif
+
+/**
+ * The frequency that the kernel ticks at in Hz. The tickless kernel counts
+ * cycles of the free-running timer, so one tick is one system clock cycle.
+ */
+#if KERNEL_TICKLESS
+#define KERNEL_TICK_FREQUENCY CLOCK_RATE
+#else
+#define KERNEL_TICK_FREQUENCY 400000
+#endif
+
+/**
+ * Works out the period of a task in kernel ticks (rounded to the nearest
+ * tick) from its frequency in Hz. A frequency of 0 gives a period of 0, which
+ * means run every tick.
+ */
+#define KERNEL_PERIOD_TICKS(t_frequency) \
+    ((t_frequency) == 0 ? 0 : (KERNEL_TICK_FREQUENCY + (t_frequency) / 2) / ((t_frequency) == 0 ? 1 : (t_frequency)))
+
+/**
+ * Converts a task budget from microseconds to clock cycles.
+ */
+#define KERNEL_BUDGET_CYCLES(t_micros) ((t_micros) * (CLOCK_RATE / 1000000))
+
+enum kernel_event_e
+{
+    KERNEL_EVENT_NONE = 0,
+    KERNEL_EVENT_ALT_SAMPLE,
+    KERNEL_EVENT_YAW_EDGE,
+    KERNEL_EVENT_YAW_REFERENCE,
+    KERNEL_EVENT_COUNT
+};
+
+/**
+ * The events that ISRs can post to the kernel to release event tasks.
+ */
+typedef enum kernel_event_e KernelEvent;
+
 struct kernel_task_s
 {
     /**
@@ -49,6 +114,11 @@ struct kernel_task_s
      */
     uint8_t priority;
 
+    /**
+     * The event that releases this task. Periodic tasks use KERNEL_EVENT_NONE.
+     */
+    uint8_t event;
+
     /**
      * Used internally to store the amount of ticks that had elapsed last time
      * the task was run.
@@ -57,15 +127,68 @@ struct kernel_task_s
     uint32_t int_count;
 
     /**
-     * The actual period for this task in microseconds.
+     * The period of the task in kernel ticks. This is calculated from the
+     * frequency when the task is added so that the kernel never has to divide
+     * when deciding if a task is due. A value of 0 means run every tick.
      */
+    uint32_t period_ticks;
+
+    /**
+     * Used internally to store the tick count at which the task is next due.
+     * DO NOT MODIFY OUTSIDE THE KERNEL MODULE!!!!
+     */
+    uint32_t due_count;
+
+    /**
+     * Used internally to store the clock cycle count when the task last started.
+     * DO NOT MODIFY OUTSIDE THE KERNEL MODULE!!!!
+     */
+    uint32_t start_cycles;
+
+    /**
+     * The actual period for this task in clock cycles and in microseconds.
+     */
+    uint32_t period_cycles;
     uint32_t period_micros;
 
     /**
-     * Used internally to store the latest running time of this task (in microseconds).
+     * Used internally to store the latest running time of this task (in clock
+     * cycles and in microseconds).
      * DO NOT MODIFY OUTSIDE THE KERNEL MODULE!!!
      */
+    uint32_t duration_cycles;
     uint32_t duration_micros;
+
+    /**
+     * The longest the task is expected to run for (in clock cycles). A pass
+     * in which any task runs for longer than its budget is an overrun.
+     */
+    uint32_t budget_cycles;
+
+    /**
+     * The number of times the task has run for longer than its budget.
+     */
+    uint32_t overrun_count;
+
+    /**
+     * The number of releases of the task that were skipped to recover from
+     * an overrun.
+     */
+    uint32_t shed_count;
+
+    /**
+     * Used internally to store the number of releases in a row that have
+     * been shed.
+     * DO NOT MODIFY OUTSIDE THE KERNEL MODULE!!!!
+     */
+    uint8_t shed_streak;
+
+    /**
+     * Used internally to store whether the task has run yet, and so whether
+     * start_cycles holds the start of its last run.
+     * DO NOT MODIFY OUTSIDE THE KERNEL MODULE!!!!
+     */
+    bool has_run;
 };
 
 /**
@@ -74,14 +197,157 @@ struct kernel_task_s
 typedef struct kernel_task_s KernelTask;
 
 /**
- * Initialises the kernel.
+ * An entry in the task table for a task that runs at a fixed frequency.
+ * The budget is the longest the task should take to run (in microseconds).
+ * Everything not listed here starts at 0.
+ */
+#define KERNEL_TASK(t_name, t_function, t_frequency, t_priority, t_budget) \
+    { \
+        .name = #t_name, \
+        .function = &t_function, \
+        .frequency = t_frequency, \
+        .priority = t_priority, \
+        .event = KERNEL_EVENT_NONE, \
+        .period_ticks = KERNEL_PERIOD_TICKS(t_frequency), \
+        .due_count = KERNEL_PERIOD_TICKS(t_frequency), \
+        .budget_cycles = KERNEL_BUDGET_CYCLES(t_budget) \
+    },
+
+/**
+ * An entry in the task table for a task that is run (once) on the next pass
+ * after its event has been posted, rather than at a fixed frequency.
+ */
+#define KERNEL_EVENT_TASK(t_name, t_function, t_event, t_priority, t_budget) \
+    { \
+        .name = #t_name, \
+        .function = &t_function, \
+        .frequency = 0, \
+        .priority = t_priority, \
+        .event = t_event, \
+        .budget_cycles = KERNEL_BUDGET_CYCLES(t_budget) \
+    },
+
+/**
+ * Fails to compile if t_condition (a constant expression) is false. t_name
+ * says what is wrong, and shows up in the compiler's error.
+ */
+#define KERNEL_STATIC_ASSERT(t_condition, t_name) \
+    typedef char t_name[(t_condition) ? 1 : -1]
+
+/**
+ * Expands a task table macro, such as main.c's KERNEL_TASKS, into a constant
+ * expression that is true if the tasks are in priority order (highest
+ * first). Each entry becomes "p) && (p <=", which chains the priority of each
+ * task to the next.
+ */
+#define KERNEL_PRIORITY_ORDER_ENTRY(t_name, t_function, t_when, t_priority, t_budget) \
+    t_priority) && (t_priority <=
+#define KERNEL_TASKS_IN_PRIORITY_ORDER(t_tasks) \
+    ((0 <= t_tasks(KERNEL_PRIORITY_ORDER_ENTRY, KERNEL_PRIORITY_ORDER_ENTRY) UINT8_MAX))
+
+struct kernel_histogram_s
+{
+    /**
+     * The number of samples that fell into each logarithmic bucket.
+     */
+    uint32_t buckets[KERNEL_HISTOGRAM_BUCKETS];
+
+    /**
+     * The total number of samples.
+     */
+    uint32_t count;
+
+    /**
+     * The smallest and largest samples.
+     */
+    int32_t min;
+    int32_t max;
+};
+
+/**
+ * A histogram of samples in logarithmic buckets.
+ */
+typedef struct kernel_histogram_s KernelHistogram;
+
+struct kernel_task_stats_s
+{
+    /**
+     * The execution time of the task (in clock cycles).
+     */
+    KernelHistogram duration;
+
+    /**
+     * The actual period minus the nominal period of the task (in clock cycles).
+     * This is only recorded for tasks that have a frequency.
+     */
+    KernelHistogram jitter;
+};
+
+/**
+ * The timing statistics that are kept for each task.
+ */
+typedef struct kernel_task_stats_s KernelTaskStats;
+
+struct kernel_clock_s
+{
+    /**
+     * Called when the clock is selected. May be NULL.
+     */
+    void (*init)(void);
+
+    /**
+     * Returns the number of cycles counted so far. This must count at the
+     * system clock frequency and wrap around at 2^32.
+     */
+    uint32_t (*read)(void);
+};
+
+/**
+ * A source of cycle counts for timing the kernel tasks.
+ */
+typedef struct kernel_clock_s KernelClock;
+
+/**
+ * Counts cycles using the kernel tick (the SysTick count and counter, or the
+ * free-running timer in tickless mode).
+ */
+extern const KernelClock KERNEL_CLOCK_TICK;
+
+/**
+ * Counts cycles using the Cortex-M4 DWT cycle counter. This is the default
+ * on the board.
+ */
+extern const KernelClock KERNEL_CLOCK_DWT;
+
+/**
+ * A deterministic clock that only moves when kernel_clock_advance is called.
+ * This is the default in the host build.
  */
-void kernel_init(uint32_t t_frequency);
+extern const KernelClock KERNEL_CLOCK_VIRTUAL;
 
 /**
- * Adds a task with a priority level (higher is lower priority) to the kernel.
+ * Initialises the kernel with a table of tasks built with KERNEL_TASK and
+ * KERNEL_EVENT_TASK. The table must be in priority order (a lower priority
+ * number first) and is used in place, so it must outlive the kernel.
+ * A table that is too big or out of order stops the program here (with a
+ * message in the host build). KERNEL_STATIC_ASSERT and
+ * KERNEL_TASKS_IN_PRIORITY_ORDER catch both when a table is compiled.
+ * In tickless mode (KERNEL_TICKLESS) the kernel counts cycles of a
+ * free-running timer instead of SysTick interrupts.
  */
-void kernel_add_task(char* t_name, void* t_func_ptr, uint16_t t_frequency, uint8_t t_priority);
+void kernel_init(KernelTask* t_tasks, uint8_t t_task_count);
+
+/**
+ * Posts an event to the kernel. This is safe to call from ISRs as long as
+ * all of the posting ISRs have the same interrupt priority (so they can't
+ * preempt one another). Events with no task bound to them are ignored.
+ */
+void kernel_post_event(KernelEvent t_event);
+
+/**
+ * Returns the number of events that were dropped because the queue was full.
+ */
+uint32_t kernel_get_event_overflows(void);
 
 /**
  * Runs the next kernel task.
@@ -89,25 +355,91 @@ void kernel_add_task(char* t_name, void* t_func_ptr, uint16_t t_frequency, uint8
 void kernel_run(void);
 
 /**
- * Returns true if memory was allocated ok. Nothing will run if this returns false.
+ * Returns true if the task table was accepted. kernel_init stops the
+ * program rather than return with a table that it didn't accept.
  */
 bool kernel_ready(void);
 
+/**
+ * Selects the clock used to time tasks. kernel_init selects the default clock
+ * so this must be called afterwards.
+ */
+void kernel_set_clock(const KernelClock* t_clock);
+
+/**
+ * Moves the virtual clock forward by some number of cycles.
+ */
+void kernel_clock_advance(uint32_t t_cycles);
+
+/**
+ * Returns the cycle count of the selected clock.
+ */
+uint32_t kernel_get_cycle_count(void);
+
 /**
  * Returns the number of times the SysTick interrupt was called.
+ * In tickless mode this is the value of the free-running timer.
  */
 uint32_t kernel_get_systick_count(void);
 
 /**
- * Returns the frequency the kernel was initialised with.
+ * Returns the frequency the kernel ticks at (KERNEL_TICK_FREQUENCY).
  */
 uint32_t kernel_get_frequency(void);
 
+/**
+ * Returns the number of processor cycles spent in the scheduler itself
+ * (i.e. excluding the task bodies) during the most recent kernel pass.
+ * The worst pass since the last call is written to t_max and then reset.
+ */
+uint32_t kernel_get_overhead_cycles(uint32_t* t_max);
+
+/**
+ * Returns the longest kernel pass (in processor cycles, including the task
+ * bodies) since the last call. The most tasks run in a single pass is
+ * written to t_max_tasks. Both are then reset.
+ */
+uint32_t kernel_get_pass_peak(uint8_t* t_max_tasks);
+
+/**
+ * Returns how much of the time since the last call was spent running kernel
+ * passes, in the SysTick interrupt and idle (all in tenths of a percent).
+ * Idle is the rest of the time, whether the kernel slept or spun between
+ * passes, so it is measured the same way in both modes. Only the periodic
+ * kernel takes the SysTick interrupt.
+ */
+void kernel_get_load(uint16_t* t_busy_permille, uint16_t* t_tick_permille, uint16_t* t_idle_permille);
+
+/**
+ * Returns the number of task releases that have been shed since the kernel
+ * was initialised. The number of passes that overran is written to
+ * t_overruns.
+ */
+uint32_t kernel_get_shed_count(uint32_t* t_overruns);
+
 /**
  * Returns all of the kernel tasks as an array.
  */
 KernelTask* kernel_get_tasks(uint8_t* t_size);
 
+/**
+ * Returns the timing statistics of the task at index t_index of the array
+ * returned by kernel_get_tasks. Returns NULL if the index is out of range.
+ */
+const KernelTaskStats* kernel_get_task_stats(uint8_t t_index);
+
+/**
+ * Clears the timing statistics of the task at index t_index.
+ */
+void kernel_reset_task_stats(uint8_t t_index);
+
+/**
+ * Returns an upper bound for the given percentile (e.g. 99) of a histogram.
+ * This is the top of the bucket the percentile falls in, limited to the
+ * largest sample. Returns 0 if the histogram is empty.
+ */
+int32_t kernel_histogram_percentile(const KernelHistogram* t_histogram, uint8_t t_percent);
+
 /**
  * A task that does nothing but busy-waits for a period of time.
  * Used to examine the effects of kernel task time saturation.
@@ -115,10 +447,9 @@ KernelTask* kernel_get_tasks(uint8_t* t_size);
 void kernel_saturation_task(KernelTask* t_task);
 
 /**
- * Prioritisises the kernel tasks. This involves sorting the kernel
- * task list by priority. This must be called after adding kernel tasks
- * or changing task priorities.
+ * A task that does nothing. Used to pad the task list when measuring how the
+ * scheduler overhead scales with the number of tasks.
  */
-void kernel_prioritise(void);
+void kernel_benchmark_task(KernelTask* t_task);
 
 #endif /* KERNEL_H_ */
@@ -36,6 +36,7 @@
 #include "setpoint.h"
 #include "uart.h"
 #include "utils.h"
+#include "vehicle_state.h"
 #include "yaw.h"
 
 #if !CONFIG_DIRECT_CONTROL
@@ -56,60 +57,187 @@ static const float YAW_KD = 0.8f;
 
 #endif
 
-/**
- * The "frequency" that the kernel runs at in Hz.
- */
-static const int KERNEL_FREQUENCY = 400000;
+// the task settings are macros rather than static consts because the task
+// table below is built at compile time.
+// each task also has a budget, the longest it should take to run in
+// microseconds. a task that runs over its budget makes the kernel shed the
+// tasks at KERNEL_SHED_PRIORITY (the display and UART) until it recovers.
 
 // process ADC stuff 512 times per second
-static const uint16_t ALT_ADC_FREQUENCY = 512;
-static const uint8_t ALT_ADC_PRIORITY = 1;
+#define ALT_ADC_FREQUENCY ALT_ADC_SAMPLE_FREQUENCY
+#define ALT_ADC_PRIORITY 1
+#define ALT_ADC_BUDGET 50
+
+// update the altitude whenever a new sample arrives (512 times a second, or
+// ALT_ADC_EVENT_FREQUENCY times a second when the ADC is timer triggered)
+#define ALT_CALC_PRIORITY 2
+#define ALT_CALC_BUDGET 100
 
-// update the altitude 512 times a second
-static const uint16_t ALT_CALC_FREQUENCY = 512;
-static const uint8_t ALT_CALC_PRIORITY = 2;
+// estimate the yaw rate 100 times per second, ahead of the yaw control
+#define YAW_RATE_FREQUENCY 100
+#define YAW_RATE_PRIORITY 4
+#define YAW_RATE_BUDGET 50
 
 // update the altitude settling 10 times per second
-static const uint16_t ALT_SETTLING_FREQUENCY = 10;
-static const uint8_t ALT_SETTLING_PRIORITY = 10;
+#define ALT_SETTLING_FREQUENCY 10
+#define ALT_SETTLING_PRIORITY 10
+#define ALT_SETTLING_BUDGET 50
 
 // update the yaw settling 10 times per second
-static const uint16_t YAW_SETTLING_FREQUENCY = 10;
-static const uint8_t YAW_SETTLING_PRIORITY = 10;
-
+#define YAW_SETTLING_FREQUENCY 10
+#define YAW_SETTLING_PRIORITY 10
+#define YAW_SETTLING_BUDGET 50
+
+#if KERNEL_TICKLESS
+// poll the input 100 times per second. a task that runs on every pass
+// would stop the tickless kernel from ever going to sleep.
+#define INPUT_FREQUENCY 100
+#else
 // always process input
-static const uint16_t INPUT_FREQUENCY = 0;
-static const uint8_t INPUT_PRIORITY = 50;
-
-#if !CONFIG_DIRECT_CONTROL
+#define INPUT_FREQUENCY 0
+#endif
+#define INPUT_PRIORITY 50
+#define INPUT_BUDGET 200
 
 // perform altitude control stuff 30 times per second
-static const uint16_t CONTROL_ALT_FREQUENCY = 30;
-static const uint8_t CONTROL_ALT_PRIORITY = 5;
+#define CONTROL_ALT_FREQUENCY 30
+#define CONTROL_ALT_PRIORITY 5
+#define CONTROL_ALT_BUDGET 200
 
 // perform yaw control stuff 30 times per second
-static const uint16_t CONTROL_YAW_FREQUENCY = 30;
-static const uint8_t CONTROL_YAW_PRIORITY = 5;
+#define CONTROL_YAW_FREQUENCY 30
+#define CONTROL_YAW_PRIORITY 5
+#define CONTROL_YAW_BUDGET 200
 
 // run state checking 20 times per sec
-static const uint16_t FLIGHT_MODE_FREQUENCY = 20;
-static const uint8_t FLIGHT_MODE_PRIORITY = 10;
+#define FLIGHT_MODE_FREQUENCY 20
+#define FLIGHT_MODE_PRIORITY 10
+#define FLIGHT_MODE_BUDGET 200
+
+// update the screen once per second (this can be shed)
+#define DISPLAY_FREQUENCY 1
+#define DISPLAY_PRIORITY KERNEL_SHED_PRIORITY
+#define DISPLAY_BUDGET 20000
 
+// send flight data four times per second via UART (this can be shed).
+// the UART blocks once its FIFO is full so this takes a while at 9600 baud.
+#define UART_FLIGHT_DATA_FREQUENCY 4
+#define UART_FLIGHT_DATA_PRIORITY KERNEL_SHED_PRIORITY
+#define UART_FLIGHT_DATA_BUDGET 40000
+
+// send kernel timing data once per second via UART
+#define UART_KERNEL_DATA_FREQUENCY 1
+#define UART_KERNEL_DATA_PRIORITY KERNEL_SHED_PRIORITY
+#define UART_KERNEL_DATA_BUDGET 1000000
+
+// run the empty benchmark tasks at the same rate as the altitude tasks
+#define KERNEL_BENCHMARK_FREQUENCY 512
+#define KERNEL_BENCHMARK_PRIORITY KERNEL_SHED_PRIORITY
+#define KERNEL_BENCHMARK_BUDGET 10
+
+// the parts of the task table that depend on the configuration.
+// the preprocessor can't use #if inside a macro, so each optional part is a
+// macro of its own that is empty when the part is turned off.
+#if ALT_ADC_TIMER_TRIGGER
+// the ADC is triggered by a timer, so no task is needed to start conversions
+#define ALT_ADC_TASKS(TASK)
+#else
+#define ALT_ADC_TASKS(TASK) \
+    TASK(altitude_adc, alt_process_adc, ALT_ADC_FREQUENCY, ALT_ADC_PRIORITY, ALT_ADC_BUDGET)
 #endif
 
-// update the screen once per second
-static const uint16_t DISPLAY_FREQUENCY = 1;
-static const uint8_t DISPLAY_PRIORITY = 100;
+#if SATURATE_KERNEL
+// hold up the system with the highest priority task. it always runs over its
+// budget, so the kernel will be shedding tasks.
+#define SATURATION_TASKS(TASK) \
+    TASK(kernel_saturation, kernel_saturation_task, 4, 0, 1000)
+#else
+#define SATURATION_TASKS(TASK)
+#endif
 
-// send flight data four times per second via UART
-static const uint16_t UART_FLIGHT_DATA_FREQUENCY = 4;
-static const uint8_t UART_FLIGHT_DATA_PRIORITY = 100;
+#if !CONFIG_DIRECT_CONTROL
+// we don't use the control systems if we are in direct control
+#define CONTROL_TASKS(TASK) \
+    TASK(altitude_control, control_update_altitude, CONTROL_ALT_FREQUENCY, CONTROL_ALT_PRIORITY, CONTROL_ALT_BUDGET) \
+    TASK(yaw_control, control_update_yaw, CONTROL_YAW_FREQUENCY, CONTROL_YAW_PRIORITY, CONTROL_YAW_BUDGET)
+
+// also check the flight mode as soon as the yaw reference is found
+#define FLIGHT_MODE_TASKS(TASK, EVENT_TASK) \
+    TASK(flight_mode, flight_mode_update, FLIGHT_MODE_FREQUENCY, FLIGHT_MODE_PRIORITY, FLIGHT_MODE_BUDGET) \
+    EVENT_TASK(flight_mode_ref, flight_mode_update, KERNEL_EVENT_YAW_REFERENCE, FLIGHT_MODE_PRIORITY, FLIGHT_MODE_BUDGET)
+#else
+#define CONTROL_TASKS(TASK)
+#define FLIGHT_MODE_TASKS(TASK, EVENT_TASK)
+#endif
 
 #if DUMP_KERNEL_DATA
-// send kernel timing data once per second via UART
-static const uint16_t UART_KERNEL_DATA_FREQUENCY = 1;
-static const uint8_t UART_KERNEL_DATA_PRIORITY = 100;
+#define UART_KERNEL_DATA_TASKS(TASK) \
+    TASK(uart_kernel_data, uart_kernel_data_update, UART_KERNEL_DATA_FREQUENCY, UART_KERNEL_DATA_PRIORITY, UART_KERNEL_DATA_BUDGET)
+#else
+#define UART_KERNEL_DATA_TASKS(TASK)
+#endif
+
+// pad the task list with KERNEL_BENCHMARK_TASKS empty tasks to measure the
+// scheduler overhead on the board. the count is built up from its binary
+// digits, and the table must still fit in KERNEL_MAX_TASKS (which is checked
+// below). host/bench/kernel_bench.c measures bigger tables on the host.
+#define BENCHMARK_TASK(TASK) \
+    TASK(kernel_benchmark, kernel_benchmark_task, KERNEL_BENCHMARK_FREQUENCY, KERNEL_BENCHMARK_PRIORITY, KERNEL_BENCHMARK_BUDGET)
+#if KERNEL_BENCHMARK_TASKS & 1
+#define BENCHMARK_TASKS_1(TASK) BENCHMARK_TASK(TASK)
+#else
+#define BENCHMARK_TASKS_1(TASK)
+#endif
+#if KERNEL_BENCHMARK_TASKS & 2
+#define BENCHMARK_TASKS_2(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK)
+#else
+#define BENCHMARK_TASKS_2(TASK)
+#endif
+#if KERNEL_BENCHMARK_TASKS & 4
+#define BENCHMARK_TASKS_4(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK)
+#else
+#define BENCHMARK_TASKS_4(TASK)
+#endif
+#if KERNEL_BENCHMARK_TASKS & 8
+#define BENCHMARK_TASKS_8(TASK) \
+    BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) \
+    BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK) BENCHMARK_TASK(TASK)
+#else
+#define BENCHMARK_TASKS_8(TASK)
 #endif
+#define BENCHMARK_TASKS(TASK) \
+    BENCHMARK_TASKS_1(TASK) BENCHMARK_TASKS_2(TASK) BENCHMARK_TASKS_4(TASK) BENCHMARK_TASKS_8(TASK)
+
+/**
+ * The kernel tasks, written out in priority order (highest first). Each entry
+ * is either TASK(name, function, frequency, priority, budget) or
+ * EVENT_TASK(name, function, event, priority, budget).
+ */
+#define KERNEL_TASKS(TASK, EVENT_TASK) \
+    SATURATION_TASKS(TASK) \
+    ALT_ADC_TASKS(TASK) \
+    EVENT_TASK(altitude_calc, alt_update, KERNEL_EVENT_ALT_SAMPLE, ALT_CALC_PRIORITY, ALT_CALC_BUDGET) \
+    TASK(yaw_rate, yaw_update_rate, YAW_RATE_FREQUENCY, YAW_RATE_PRIORITY, YAW_RATE_BUDGET) \
+    CONTROL_TASKS(TASK) \
+    TASK(altitude_settling, alt_update_settling, ALT_SETTLING_FREQUENCY, ALT_SETTLING_PRIORITY, ALT_SETTLING_BUDGET) \
+    TASK(yaw_settling, yaw_update_settling, YAW_SETTLING_FREQUENCY, YAW_SETTLING_PRIORITY, YAW_SETTLING_BUDGET) \
+    FLIGHT_MODE_TASKS(TASK, EVENT_TASK) \
+    TASK(input, input_update, INPUT_FREQUENCY, INPUT_PRIORITY, INPUT_BUDGET) \
+    TASK(display, disp_render, DISPLAY_FREQUENCY, DISPLAY_PRIORITY, DISPLAY_BUDGET) \
+    TASK(uart_flight_data, uart_flight_data_update, UART_FLIGHT_DATA_FREQUENCY, UART_FLIGHT_DATA_PRIORITY, UART_FLIGHT_DATA_BUDGET) \
+    UART_KERNEL_DATA_TASKS(TASK) \
+    BENCHMARK_TASKS(TASK)
+
+/**
+ * The task table. The kernel keeps the running state of each task in here.
+ */
+static KernelTask g_kernel_tasks[] = {
+    KERNEL_TASKS(KERNEL_TASK, KERNEL_EVENT_TASK)
+};
+
+// a table that kernel_init would reject doesn't compile
+KERNEL_STATIC_ASSERT(sizeof(g_kernel_tasks) / sizeof(KernelTask) <= KERNEL_MAX_TASKS, kernel_tasks_too_many);
+KERNEL_STATIC_ASSERT(KERNEL_TASKS_IN_PRIORITY_ORDER(KERNEL_TASKS), kernel_tasks_out_of_priority_order);
 
 /**
  * The amount of time to display the splash screen (in seconds)
@@ -122,7 +250,9 @@ void initialise(void)
     // disable all interrupts
     IntMasterDisable();
 
-    // Setup all required modules
+    // Setup all required modules. the vehicle state comes first as the
+    // others publish to it.
+    vehicle_state_init();
     clock_init();
     alt_init();
     disp_init();
@@ -130,7 +260,7 @@ void initialise(void)
     uart_init();
     input_init();
     pwm_init();
-    kernel_init(KERNEL_FREQUENCY);
+    kernel_init(g_kernel_tasks, sizeof(g_kernel_tasks) / sizeof(KernelTask));
     setpoint_init();
     flight_mode_init();
 
@@ -140,32 +270,6 @@ void initialise(void)
                  (ControlGains){YAW_KP, YAW_KI, YAW_KD});
 #endif
 
-    // add tasks to the kernel
-    kernel_add_task("altitude_adc", &alt_process_adc, ALT_ADC_FREQUENCY, ALT_ADC_PRIORITY);
-    kernel_add_task("altitude_calc", &alt_update, ALT_CALC_FREQUENCY, ALT_CALC_PRIORITY);
-    kernel_add_task("altitude_settling", &alt_update_settling, ALT_SETTLING_FREQUENCY, ALT_SETTLING_PRIORITY);
-    kernel_add_task("yaw_settling", &yaw_update_settling, YAW_SETTLING_FREQUENCY, YAW_SETTLING_PRIORITY);
-    kernel_add_task("input", &input_update, INPUT_FREQUENCY, INPUT_PRIORITY);
-#if !CONFIG_DIRECT_CONTROL
-    kernel_add_task("altitude_control", &control_update_altitude, CONTROL_ALT_FREQUENCY, CONTROL_ALT_PRIORITY);
-    kernel_add_task("yaw_control", &control_update_yaw, CONTROL_YAW_FREQUENCY, CONTROL_YAW_PRIORITY);
-    kernel_add_task("flight_mode", &flight_mode_update, FLIGHT_MODE_FREQUENCY, FLIGHT_MODE_PRIORITY);
-#endif
-    kernel_add_task("display", &disp_render, DISPLAY_FREQUENCY, DISPLAY_PRIORITY);
-    kernel_add_task("uart_flight_data", &uart_flight_data_update, UART_FLIGHT_DATA_FREQUENCY, UART_FLIGHT_DATA_PRIORITY);
-
-#if DUMP_KERNEL_DATA
-    kernel_add_task("uart_kernel_data", &uart_kernel_data_update, UART_KERNEL_DATA_FREQUENCY, UART_KERNEL_DATA_PRIORITY);
-#endif
-
-#if SATURATE_KERNEL
-    // add a kernel task to hold up the system with the highest priority and frequency
-    kernel_add_task("kernel_saturation", &kernel_saturation_task, 4, 0);
-#endif
-
-    // ensure the kernel tasks are in priority order
-    kernel_prioritise();
-
     // Enable interrupts to the processor.
     IntMasterEnable();
 
@@ -175,6 +279,9 @@ void initialise(void)
     disp_advance_state();
 }
 
+// the host build provides its own main (host/host_main.c)
+#if !CONFIG_HOST_BUILD
+
 /**
  * The main loop of the program.
  * Initialises the modules and runs the kernel forever.
@@ -188,3 +295,5 @@ int main(void)
         kernel_run();
     }
 }
+
+#endif
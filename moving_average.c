@@ -0,0 +1,65 @@
+/*******************************************************************************
+ *
+ * moving_average.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a moving average filter. It keeps a running sum of
+ * the samples in its window, so adding a sample and getting the mean both
+ * take the same time however wide the window is.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "moving_average.h"
+
+void moving_average_init(MovingAverage* t_average, uint32_t* t_samples, uint16_t t_size)
+{
+    t_average->samples = t_samples;
+    t_average->size = t_size;
+    t_average->index = 0;
+    t_average->sum = 0;
+    memset(t_samples, 0, t_size * sizeof(uint32_t));
+
+    t_average->is_power_of_two = (t_size & (t_size - 1)) == 0;
+    t_average->shift = 0;
+    while ((1u << t_average->shift) < t_size)
+    {
+        t_average->shift++;
+    }
+}
+
+void moving_average_add(MovingAverage* t_average, uint32_t t_sample)
+{
+    // swap the oldest sample for the new one in the running sum
+    t_average->sum += t_sample - t_average->samples[t_average->index];
+    t_average->samples[t_average->index] = t_sample;
+
+    t_average->index++;
+    if (t_average->index >= t_average->size)
+    {
+        t_average->index = 0;
+    }
+}
+
+uint32_t moving_average_get(const MovingAverage* t_average)
+{
+    // add half the size first so that the mean is rounded
+    uint32_t sum = t_average->sum + t_average->size / 2;
+
+    if (t_average->is_power_of_two)
+    {
+        return sum >> t_average->shift;
+    }
+    return sum / t_average->size;
+}
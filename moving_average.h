@@ -0,0 +1,58 @@
+/*******************************************************************************
+ *
+ * moving_average.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a moving average filter. It keeps a running sum of
+ * the samples in its window, so adding a sample and getting the mean both
+ * take the same time however wide the window is.
+ *
+ ******************************************************************************/
+
+#ifndef MOVING_AVERAGE_H_
+#define MOVING_AVERAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A moving average over the last `size` samples. The samples are stored in
+ * an array given to moving_average_init.
+ */
+typedef struct {
+    uint32_t* samples;
+    uint16_t size;
+    uint16_t index;
+    uint32_t sum;
+
+    // the mean is found with a shift when the size is a power of 2
+    bool is_power_of_two;
+    uint8_t shift;
+} MovingAverage;
+
+/**
+ * Initialises a moving average over the t_size samples in t_samples. The
+ * window starts out full of zeros.
+ */
+void moving_average_init(MovingAverage* t_average, uint32_t* t_samples, uint16_t t_size);
+
+/**
+ * Adds a sample to the window, replacing the oldest one.
+ */
+void moving_average_add(MovingAverage* t_average, uint32_t t_sample);
+
+/**
+ * Returns the mean of the samples in the window (rounded to the nearest
+ * whole number).
+ */
+uint32_t moving_average_get(const MovingAverage* t_average);
+
+#endif /* MOVING_AVERAGE_H_ */
@@ -40,6 +40,7 @@
 
 #include "pwm.h"
 #include "utils.h"
+#include "vehicle_state.h"
 
 // Common PWM constants
 
@@ -204,6 +205,7 @@ void pwm_set_main_duty(int8_t t_duty)
     g_main_duty = clamp(t_duty, 0, 100);
     PWMPulseWidthSet(PWM_MAIN_BASE, PWM_MAIN_OUTNUM,
                      g_pwm_period * g_main_duty / 100);
+    vehicle_state_publish_duty(g_main_duty, g_tail_duty);
 }
 
 int8_t pwm_get_main_duty(void)
@@ -216,6 +218,7 @@ void pwm_set_tail_duty(int8_t t_duty)
     g_tail_duty = clamp(t_duty, 0, 100);
     PWMPulseWidthSet(PWM_TAIL_BASE, PWM_TAIL_OUTNUM,
                      g_pwm_period * g_tail_duty / 100);
+    vehicle_state_publish_duty(g_main_duty, g_tail_duty);
 }
 
 int8_t pwm_get_tail_duty(void)
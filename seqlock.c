@@ -0,0 +1,63 @@
+/*******************************************************************************
+ *
+ * seqlock.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a sequence lock for copying a group of values that an
+ * ISR or task writes, without locking. See seqlock.h for how it works.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "barrier.h"
+#include "seqlock.h"
+
+void seqlock_init(Seqlock* t_lock)
+{
+    t_lock->sequence = 0;
+}
+
+void seqlock_write_begin(Seqlock* t_lock)
+{
+    // only the writer changes the sequence, so it can be read plainly. the
+    // odd sequence must be seen before any of the values change.
+    t_lock->sequence++;
+    barrier_fence();
+}
+
+void seqlock_write_end(Seqlock* t_lock)
+{
+    // the values must all be seen before the sequence is even again
+    barrier_store_release(&t_lock->sequence, t_lock->sequence + 1);
+}
+
+uint32_t seqlock_read_begin(const Seqlock* t_lock)
+{
+    uint32_t sequence;
+
+    // a reader in a task never sees an odd sequence from an ISR, since the
+    // ISR finishes before the task carries on. this is for readers that run
+    // alongside the writer (such as on the host).
+    while ((sequence = barrier_load_acquire(&t_lock->sequence)) & 1)
+    {
+        continue;
+    }
+    return sequence;
+}
+
+bool seqlock_read_retry(const Seqlock* t_lock, uint32_t t_sequence)
+{
+    // the values must all be copied before the sequence is checked
+    barrier_fence();
+    return t_lock->sequence != t_sequence;
+}
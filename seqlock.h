@@ -0,0 +1,69 @@
+/*******************************************************************************
+ *
+ * seqlock.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a sequence lock, which lets one writer (such as an
+ * ISR) update a group of values that any number of readers can copy
+ * consistently, without the readers locking anything or turning interrupts
+ * off. The writer makes the sequence odd before it starts and even again
+ * once it has finished. A reader notes the sequence before it copies the
+ * values and copies them again if the sequence has changed since.
+ *
+ * The values themselves should be volatile so that the compiler keeps them
+ * between the sequence reads.
+ *
+ ******************************************************************************/
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A sequence lock. The sequence counts two for every write, so half of it is
+ * the number of writes (the version of the values).
+ */
+typedef struct {
+    volatile uint32_t sequence;
+} Seqlock;
+
+/**
+ * Initialises the lock. This must be done before the writer or readers start.
+ */
+void seqlock_init(Seqlock* t_lock);
+
+/**
+ * Writer only. Marks the values as being written. Writes can't be nested, so
+ * if more than one context writes, they must not be able to interrupt each
+ * other.
+ */
+void seqlock_write_begin(Seqlock* t_lock);
+
+/**
+ * Writer only. Marks the values as written.
+ */
+void seqlock_write_end(Seqlock* t_lock);
+
+/**
+ * Returns the sequence to pass to seqlock_read_retry once the values have
+ * been copied. If the writer is part way through, this waits for it.
+ */
+uint32_t seqlock_read_begin(const Seqlock* t_lock);
+
+/**
+ * Returns true if the values were written while they were being copied, in
+ * which case they must be copied again.
+ */
+bool seqlock_read_retry(const Seqlock* t_lock, uint32_t t_sequence);
+
+#endif /* SEQLOCK_H_ */
@@ -0,0 +1,135 @@
+/*******************************************************************************
+ *
+ * settling.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module decides when a value (such as the altitude or the yaw) has
+ * settled, which is when the last few values all lie within a margin of each
+ * other. The smallest and largest values in the window are each kept at the
+ * front of a monotonic deque, so adding a value and asking if it has settled
+ * take the same (amortised) time however wide the window is.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "settling.h"
+
+/**
+ * Returns the entry at t_offset from the front of a deque.
+ */
+static SettlingEntry* settling_entry(SettlingEntry* t_entries, uint16_t t_head, uint16_t t_offset, uint16_t t_size)
+{
+    uint16_t position = t_head + t_offset;
+    if (position >= t_size)
+    {
+        position -= t_size;
+    }
+    return &t_entries[position];
+}
+
+/**
+ * Adds a value to the back of a deque. Values that have left the window are
+ * taken off the front, and values that can no longer be the front (as they
+ * are older and no better than t_value) are taken off the back. t_is_min
+ * picks whether the front is the smallest or the largest value.
+ */
+static void settling_push(SettlingEntry* t_entries, uint16_t* t_head, uint16_t* t_length, uint16_t t_size,
+                          bool t_is_min, int32_t t_value, uint32_t t_index)
+{
+    // the window holds the values from t_index - t_size + 1 to t_index. this
+    // is done first so there is room for the new value.
+    if (*t_length > 0 && t_index - t_entries[*t_head].index >= t_size)
+    {
+        (*t_head)++;
+        if (*t_head >= t_size)
+        {
+            *t_head = 0;
+        }
+        (*t_length)--;
+    }
+
+    while (*t_length > 0)
+    {
+        int32_t back = settling_entry(t_entries, *t_head, *t_length - 1, t_size)->value;
+        if (t_is_min ? back < t_value : back > t_value)
+        {
+            break;
+        }
+        (*t_length)--;
+    }
+
+    SettlingEntry* entry = settling_entry(t_entries, *t_head, *t_length, t_size);
+    entry->value = t_value;
+    entry->index = t_index;
+    (*t_length)++;
+}
+
+void settling_init(Settling* t_settling, SettlingEntry* t_entries, uint16_t t_size, int32_t t_margin)
+{
+    t_settling->min_entries = t_entries;
+    t_settling->max_entries = t_entries + t_size;
+    t_settling->min_head = 0;
+    t_settling->min_length = 0;
+    t_settling->max_head = 0;
+    t_settling->max_length = 0;
+    t_settling->size = t_size;
+    t_settling->margin = t_margin;
+    t_settling->index = 0;
+    t_settling->is_full = false;
+}
+
+void settling_add(Settling* t_settling, int32_t t_value)
+{
+    settling_push(t_settling->min_entries, &t_settling->min_head, &t_settling->min_length,
+                  t_settling->size, true, t_value, t_settling->index);
+    settling_push(t_settling->max_entries, &t_settling->max_head, &t_settling->max_length,
+                  t_settling->size, false, t_value, t_settling->index);
+
+    t_settling->index++;
+    if (t_settling->index >= t_settling->size)
+    {
+        t_settling->is_full = true;
+    }
+}
+
+int32_t settling_get_min(const Settling* t_settling)
+{
+    return t_settling->min_entries[t_settling->min_head].value;
+}
+
+int32_t settling_get_max(const Settling* t_settling)
+{
+    return t_settling->max_entries[t_settling->max_head].value;
+}
+
+bool settling_is_settled(const Settling* t_settling)
+{
+    return t_settling->is_full
+        && settling_get_max(t_settling) - settling_get_min(t_settling) <= t_settling->margin * 2;
+}
+
+int32_t settling_get_settled(const Settling* t_settling)
+{
+    return settling_get_min(t_settling) + t_settling->margin;
+}
+
+bool settling_is_settled_around(const Settling* t_settling, int32_t t_value)
+{
+    if (!settling_is_settled(t_settling))
+    {
+        return false;
+    }
+
+    int32_t settled = settling_get_settled(t_settling);
+    return settled >= t_value - t_settling->margin && settled <= t_value + t_settling->margin;
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+ *
+ * settling.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module decides when a value (such as the altitude or the yaw) has
+ * settled, which is when the last few values all lie within a margin of each
+ * other. The smallest and largest values in the window are each kept at the
+ * front of a monotonic deque, so adding a value and asking if it has settled
+ * take the same (amortised) time however wide the window is.
+ *
+ ******************************************************************************/
+
+#ifndef SETTLING_H_
+#define SETTLING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A value in one of the deques, along with when it was added.
+ */
+typedef struct {
+    int32_t value;
+    uint32_t index;
+} SettlingEntry;
+
+/**
+ * Watches the last `size` values for settling. The deques are stored in an
+ * array of 2 * size entries given to settling_init.
+ */
+typedef struct {
+    // the values in the minimum deque only ever increase from the front to
+    // the back and the values in the maximum deque only ever decrease
+    SettlingEntry* min_entries;
+    SettlingEntry* max_entries;
+    uint16_t min_head;
+    uint16_t min_length;
+    uint16_t max_head;
+    uint16_t max_length;
+
+    uint16_t size;
+    int32_t margin;
+
+    // the index that the next value is added with
+    uint32_t index;
+    bool is_full;
+} Settling;
+
+/**
+ * Initialises a settling window over the last t_size values, using the
+ * 2 * t_size entries in t_entries. The values have settled when they are all
+ * within t_margin of a value (so they span no more than 2 * t_margin). The
+ * window starts out empty and can't settle until it is full.
+ */
+void settling_init(Settling* t_settling, SettlingEntry* t_entries, uint16_t t_size, int32_t t_margin);
+
+/**
+ * Adds a value to the window, replacing the oldest one.
+ */
+void settling_add(Settling* t_settling, int32_t t_value);
+
+/**
+ * Returns the smallest value in the window. The window must not be empty.
+ */
+int32_t settling_get_min(const Settling* t_settling);
+
+/**
+ * Returns the largest value in the window. The window must not be empty.
+ */
+int32_t settling_get_max(const Settling* t_settling);
+
+/**
+ * Returns true if the window is full and its values span no more than twice
+ * the margin.
+ */
+bool settling_is_settled(const Settling* t_settling);
+
+/**
+ * Returns the value that the window has settled around (the smallest value
+ * plus the margin). This is only meaningful once settling_is_settled is true.
+ */
+int32_t settling_get_settled(const Settling* t_settling);
+
+/**
+ * Returns true if the window has settled within the margin of t_value.
+ */
+bool settling_is_settled_around(const Settling* t_settling, int32_t t_value);
+
+#endif /* SETTLING_H_ */
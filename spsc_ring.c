@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *
+ * spsc_ring.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a ring buffer for passing values from one producer to
+ * one consumer (such as from an ISR to a task) without locking. See
+ * spsc_ring.h for how the indices are shared.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "barrier.h"
+#include "spsc_ring.h"
+
+void spsc_ring_init(SpscRing* t_ring, volatile uint32_t* t_items, uint32_t t_size)
+{
+    t_ring->items = t_items;
+    t_ring->mask = t_size - 1;
+    t_ring->head = 0;
+    t_ring->tail = 0;
+    t_ring->dropped = 0;
+}
+
+bool spsc_ring_push(SpscRing* t_ring, uint32_t t_item)
+{
+    // only the producer writes the head, so it can be read plainly
+    uint32_t head = t_ring->head;
+
+    if (head - barrier_load_acquire(&t_ring->tail) > t_ring->mask)
+    {
+        t_ring->dropped++;
+        return false;
+    }
+
+    // the consumer can't see the slot until the head moves past it
+    t_ring->items[head & t_ring->mask] = t_item;
+    barrier_store_release(&t_ring->head, head + 1);
+    return true;
+}
+
+bool spsc_ring_pop(SpscRing* t_ring, uint32_t* t_item)
+{
+    // only the consumer writes the tail, so it can be read plainly
+    uint32_t tail = t_ring->tail;
+
+    if (tail == barrier_load_acquire(&t_ring->head))
+    {
+        return false;
+    }
+
+    // the producer can't reuse the slot until the tail moves past it
+    *t_item = t_ring->items[tail & t_ring->mask];
+    barrier_store_release(&t_ring->tail, tail + 1);
+    return true;
+}
+
+uint32_t spsc_ring_get_dropped(const SpscRing* t_ring)
+{
+    return t_ring->dropped;
+}
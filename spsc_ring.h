@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *
+ * spsc_ring.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module contains a ring buffer for passing values from one producer to
+ * one consumer (such as from an ISR to a task) without locking. The producer
+ * only ever writes the head and the consumer only ever writes the tail. Each
+ * side publishes its index with release ordering after it has written or read
+ * the slot, and reads the other side's index with acquire ordering, so
+ * neither side can see a slot that is only half written. Neither side ever
+ * waits for the other.
+ *
+ ******************************************************************************/
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A ring of `size` values (a power of 2) stored in an array given to
+ * spsc_ring_init. The indices count every value ever pushed or popped and
+ * wrap around naturally.
+ */
+typedef struct {
+    volatile uint32_t* items;
+    uint32_t mask;
+
+    // written only by the producer
+    volatile uint32_t head;
+    volatile uint32_t dropped;
+
+    // written only by the consumer
+    volatile uint32_t tail;
+} SpscRing;
+
+/**
+ * Initialises an empty ring over the t_size values in t_items. t_size must
+ * be a power of 2. This must be done before the producer or consumer start.
+ */
+void spsc_ring_init(SpscRing* t_ring, volatile uint32_t* t_items, uint32_t t_size);
+
+/**
+ * Producer only. Adds a value to the ring and returns true, or returns false
+ * (and counts the value as dropped) if the ring is full.
+ */
+bool spsc_ring_push(SpscRing* t_ring, uint32_t t_item);
+
+/**
+ * Consumer only. Takes the oldest value from the ring and returns true, or
+ * returns false if the ring is empty.
+ */
+bool spsc_ring_pop(SpscRing* t_ring, uint32_t* t_item);
+
+/**
+ * Returns the number of values that the producer has dropped because the
+ * ring was full.
+ */
+uint32_t spsc_ring_get_dropped(const SpscRing* t_ring);
+
+#endif /* SPSC_RING_H_ */
@@ -36,14 +36,18 @@ class AnalogPlot:
 
 	# add data
 	def add(self, data):
-		if len(data) == 11:
+		# the kernel rows are named kernel_*, and kernel_overhead carries the
+		# number of tasks, so a line is only used once every task row is there
+		tasks = [row for row in data if not row[0].startswith("kernel_")]
+		overheads = [row for row in data if row[0] == "kernel_overhead"]
+		if overheads and len(tasks) == overheads[0][3]:
 			total_utilization = 0
-			for i in range(len(data)):
+			for i in range(len(tasks)):
 				utilization = 0
-				if data[i][3] != 0:
+				if tasks[i][3] != 0:
 					# duration * frequency / 1000000.0 * 100
-					utilization = data[i][1] * data[i][3] / 10000.0
-				if data[i][0] != "uart_kernel_data":
+					utilization = tasks[i][1] * tasks[i][3] / 10000.0
+				if tasks[i][0] != "uart_kernel_data":
 					total_utilization += utilization
 			self.addToBuf(self.a, total_utilization)
 			print(total_utilization )
@@ -36,11 +36,25 @@ def extract_average_duration(data, length):
     return [sum(d) / len(d) for d in all_durations]
 
 
+def mean_kernel_idle(filename):
+    """Returns the mean idle time (in %) reported by the kernel in a log."""
+    idles = []
+    with open(filename) as file:
+        for line in file.readlines():
+            for row in line.strip().split():
+                fields = row.split(',')
+                if len(fields) == 4 and fields[0] == "kernel_load":
+                    idles.append(int(fields[2]))
+    return sum(idles) / len(idles) / 10.0 if idles else None
+
+
 def main():
     # create parser
     parser = argparse.ArgumentParser(description="LDR serial")
     # add expected arguments
     parser.add_argument('--file', dest='file', required=True)
+    # a log from the other kernel mode, to work out the CPU time reclaimed
+    parser.add_argument('--compare', dest='compare', required=False)
 
     # parse args
     args = parser.parse_args()
@@ -52,6 +66,11 @@ def main():
     file = open(filename)
 
     data = {}
+    overheads = []
+    loads = []
+    ticks = []
+    sheds = []
+    passes = []
 
     ignore_uart_kernel = True
 
@@ -64,6 +83,31 @@ def main():
                 for (name, duration, period, frequency) in [(name, int(duration), int(period), int(frequency)) for (
                         name, duration, period, frequency) in raw_data]:
 
+                    # the scheduler overhead is reported as (cycles, max cycles, task count)
+                    if name == "kernel_overhead":
+                        overheads.append((duration, period, frequency))
+                        continue
+
+                    # the kernel load is reported as (busy, idle, tickless) in tenths of a percent
+                    if name == "kernel_load":
+                        loads.append((duration, period, frequency))
+                        continue
+
+                    # the SysTick interrupt is reported as (load in tenths of a percent, kHz, tickless)
+                    if name == "kernel_tick":
+                        ticks.append((duration, period, frequency))
+                        continue
+
+                    # the worst pass is reported as (cycles, tasks run, phase offsets)
+                    if name == "kernel_pass":
+                        passes.append((duration, period, frequency))
+                        continue
+
+                    # the load shedding is reported as (releases shed, passes overrun, shed priority)
+                    if name == "kernel_shed":
+                        sheds.append((duration, period, frequency))
+                        continue
+
                     # ignore the kernel uart task if specified
                     if name == "uart_kernel_data" and ignore_uart_kernel:
                         continue
@@ -99,6 +143,39 @@ def main():
     for name, avg in duration_avgs:
         print("{}: {} \u00b5s".format(name, avg))
 
+    if overheads:
+        task_count = overheads[-1][2]
+        mean_overhead = sum([o[0] for o in overheads]) / len(overheads)
+        max_overhead = max([o[1] for o in overheads])
+        print("Kernel overhead ({} tasks): {} cycles per pass (max {} cycles)".format(
+            task_count, mean_overhead, max_overhead))
+
+    if loads:
+        mode = "tickless" if loads[-1][2] else "periodic"
+        mean_busy = sum([l[0] for l in loads]) / len(loads) / 10.0
+        mean_idle = sum([l[1] for l in loads]) / len(loads) / 10.0
+        mean_tick = sum([t[0] for t in ticks]) / len(ticks) / 10.0 if ticks else 0.0
+        print("Kernel load ({}): {}% running passes, {}% in the SysTick interrupt, {}% idle".format(
+            mode, mean_busy, mean_tick, mean_idle))
+
+        # the idle time is measured the same way in both modes, so the
+        # difference is the CPU time that the tickless kernel gives back
+        if args.compare:
+            compare_idle = mean_kernel_idle(args.compare)
+            if compare_idle is not None:
+                reclaimed = mean_idle - compare_idle if loads[-1][2] else compare_idle - mean_idle
+                print("CPU time reclaimed by the tickless kernel: {}% (idle {}% here, {}% in {})".format(
+                    reclaimed, mean_idle, compare_idle, args.compare))
+
+    if passes:
+        phases = "with" if passes[-1][2] else "without"
+        print("Worst kernel pass ({} phase offsets): {} cycles, {} tasks".format(
+            phases, max([p[0] for p in passes]), max([p[1] for p in passes])))
+
+    if sheds:
+        print("Kernel shedding: {} releases shed (priority {} and up) over {} overrun passes".format(
+            sheds[-1][0], sheds[-1][2], sheds[-1][1]))
+
     # plot the data
     # CPU Utilization
     total_utilization = extract_utilization(data, n)
@@ -0,0 +1,244 @@
+"""
+schedulability.py
+
+Checks that the kernel task set can be scheduled before it is flashed.
+
+The task table (KERNEL_TASKS in main.c) is read by running it through the C
+preprocessor, so the tasks, frequencies and priorities are exactly the ones
+that would be built with the current config.h. The worst-case execution time
+of each task is its budget unless a log of the kernel timing data
+(DUMP_KERNEL_DATA) is given, in which case the largest measured duration is
+used instead.
+
+The kernel is cooperative, so this does response time analysis for
+non-preemptive fixed priority scheduling. The priority of a task is its
+position in the table. Every task can be blocked by the longest lower
+priority task (which may have just started), by the tasks that run on every
+pass and by the scheduler overhead. Releases are only seen on the next tick,
+so each task also has up to one tick of release jitter.
+
+Usage: python3 schedulability.py [--log data.txt] [--event-rate NAME=HZ ...]
+
+Exits with 1 if any task can miss its deadline (its period).
+"""
+
+import argparse
+import math
+import os
+import re
+import subprocess
+import sys
+
+
+# the processor clock rate (Hz)
+CLOCK_RATE = 40000000
+
+# the rate that each event can be posted at (Hz). a string names the task
+# whose frequency sets the rate. these are overridden by any @rate lines in
+# the expanded table source.
+EVENT_RATES = {
+    "KERNEL_EVENT_ALT_SAMPLE": "altitude_adc",
+    "KERNEL_EVENT_YAW_EDGE": 448 * 4,
+    "KERNEL_EVENT_YAW_REFERENCE": 1,
+}
+
+# the macros that the task table is expanded with
+TABLE_SOURCE = """
+#include "main.c"
+#define SCHED_TASK(t_name, t_function, t_frequency, t_priority, t_budget) \\
+    @task t_name t_frequency t_priority t_budget
+#define SCHED_EVENT_TASK(t_name, t_function, t_event, t_priority, t_budget) \\
+    @event t_name t_event t_priority t_budget
+@tick KERNEL_TICK_FREQUENCY
+#if ALT_ADC_TIMER_TRIGGER
+@rate KERNEL_EVENT_ALT_SAMPLE ALT_ADC_EVENT_FREQUENCY
+#endif
+KERNEL_TASKS(SCHED_TASK, SCHED_EVENT_TASK)
+"""
+
+
+class Task:
+    def __init__(self, name, priority, budget, frequency=0, event=None):
+        self.name = name
+        self.priority = priority
+        self.frequency = frequency
+        self.event = event
+        self.wcet = budget
+        self.source = "budget"
+        self.period = 0
+        self.blocking = 0
+
+    def runs_every_pass(self):
+        return self.event is None and self.frequency == 0
+
+
+def read_task_table(repo, compiler):
+    """Returns the kernel tick frequency, the tasks in table order and any event rates set by the build."""
+    result = subprocess.run(
+        [compiler, "-E", "-P", "-DCONFIG_HOST_BUILD=1", "-I" + os.path.join(repo, "host"), "-I" + repo, "-x", "c", "-"],
+        input=TABLE_SOURCE, cwd=repo, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True,
+        check=True)
+
+    tick = int(re.search(r"@tick (\d+)", result.stdout).group(1))
+
+    # the rates are expressions such as (512 / 4)
+    rates = {}
+    for name, value in re.findall(r"@rate (\w+) (.+)", result.stdout):
+        rates[name] = float(eval(value, {}))
+
+    tasks = []
+    for kind, name, value, priority, budget in re.findall(r"@(task|event) (\w+) (\w+) (\d+) (\d+)", result.stdout):
+        if kind == "task":
+            tasks.append(Task(name, int(priority), int(budget), frequency=int(value)))
+        else:
+            tasks.append(Task(name, int(priority), int(budget), event=value))
+
+    return tick, tasks, rates
+
+
+def read_log(filename):
+    """Returns the worst duration of each task (us) and the worst scheduler overhead (us) in a kernel data log."""
+    durations = {}
+    overhead = 0
+
+    with open(filename) as file:
+        for line in file.readlines():
+            rows = [row.split(",") for row in line.strip().split("\t") if row]
+            if not rows:
+                continue
+
+            if rows[0] == ["stats"]:
+                # name, duration p99, duration max, jitter p99, jitter max, ... (in cycles)
+                for row in rows[1:]:
+                    if len(row) >= 3:
+                        micros = int(row[2]) * 1000000.0 / CLOCK_RATE
+                        durations[row[0]] = max(durations.get(row[0], 0), micros)
+            elif "kernel_overhead" in line:
+                # name, duration (us), period (us), frequency
+                for row in rows:
+                    if len(row) != 4:
+                        continue
+                    if row[0] == "kernel_overhead":
+                        overhead = max(overhead, int(row[2]) * 1000000.0 / CLOCK_RATE)
+                    elif not row[0].startswith("kernel_"):
+                        durations[row[0]] = max(durations.get(row[0], 0), int(row[1]))
+
+    return durations, overhead
+
+
+def response_time(task, higher, jitter):
+    """
+    Returns the worst-case response time of a task under non-preemptive fixed
+    priority scheduling, or None if the level-i busy period never ends.
+    """
+    hep = higher + [task]
+
+    # the longest time the processor can be busy with this task and the
+    # tasks above it
+    busy = task.blocking + sum(t.wcet for t in hep)
+    while True:
+        next_busy = task.blocking + sum(math.ceil((busy + jitter) / t.period) * t.wcet for t in hep)
+        if next_busy == busy:
+            break
+        if next_busy > 1000 * max(t.period for t in hep):
+            return None
+        busy = next_busy
+
+    # check every job of this task released in the busy period
+    worst = 0
+    for q in range(int(math.ceil((busy + jitter) / task.period))):
+        start = task.blocking + q * task.wcet
+        while True:
+            next_start = task.blocking + q * task.wcet + \
+                sum((math.floor((start + jitter) / t.period) + 1) * t.wcet for t in higher)
+            if next_start == start:
+                break
+            start = next_start
+        worst = max(worst, start + task.wcet + jitter - q * task.period)
+
+    return worst
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Kernel schedulability analysis")
+    parser.add_argument('--log', dest='log', help="a log of the kernel timing data to take durations from")
+    parser.add_argument('--event-rate', dest='event_rates', action='append', default=[],
+                        help="the fastest an event can be posted, as NAME=HZ")
+    parser.add_argument('--cc', dest='compiler', default="cc", help="the C compiler to preprocess main.c with")
+    args = parser.parse_args()
+
+    repo = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+    tick, tasks, build_rates = read_task_table(repo, args.compiler)
+    tick_period = 1000000.0 / tick
+
+    # use the measured durations where there are any
+    overhead = 0
+    if args.log:
+        durations, overhead = read_log(args.log)
+        for task in tasks:
+            if task.name in durations:
+                task.wcet = durations[task.name]
+                task.source = "measured"
+
+    event_rates = dict(EVENT_RATES)
+    event_rates.update(build_rates)
+    for rate in args.event_rates:
+        name, hz = rate.split("=")
+        event_rates[name] = float(hz)
+
+    for task in tasks:
+        if task.event is None and task.frequency != 0:
+            # the kernel rounds the period to a whole number of ticks
+            task.period = ((tick + task.frequency // 2) // task.frequency) * tick_period
+
+    for task in tasks:
+        if task.event is not None:
+            rate = event_rates.get(task.event, 1)
+            if isinstance(rate, str):
+                task.period = [t.period for t in tasks if t.name == rate][0]
+            else:
+                task.period = 1000000.0 / rate
+
+    # tasks that run on every pass hold up every pass, so they are treated
+    # as blocking rather than being scheduled
+    every_pass = [t for t in tasks if t.runs_every_pass()]
+    scheduled = [t for t in tasks if not t.runs_every_pass()]
+    every_pass_wcet = sum(t.wcet for t in every_pass)
+
+    utilisation = sum(t.wcet / t.period for t in scheduled)
+    schedulable = utilisation <= 1
+
+    print("{:<20} {:>4} {:>10} {:>10} {:>9} {:>7} {:>10} {:>10}  {}".format(
+        "Task", "Prio", "Period", "WCET", "Source", "Util", "Blocking", "Response", "Result"))
+
+    for i, task in enumerate(scheduled):
+        lower = scheduled[i + 1:]
+        task.blocking = max([t.wcet for t in lower] + [0]) + every_pass_wcet + overhead
+
+        response = response_time(task, scheduled[:i], tick_period) if utilisation <= 1 else None
+        meets = response is not None and response <= task.period
+        schedulable = schedulable and meets
+
+        print("{:<20} {:>4} {:>8.0f}us {:>8.1f}us {:>9} {:>6.2f}% {:>8.1f}us {:>10}  {}".format(
+            task.name, task.priority, task.period, task.wcet, task.source, 100.0 * task.wcet / task.period,
+            task.blocking, "-" if response is None else "{:.1f}us".format(response), "ok" if meets else "MISS"))
+
+    for task in every_pass:
+        print("{:<20} {:>4} {:>10} {:>8.1f}us {:>9}   (runs on every pass)".format(
+            task.name, task.priority, "-", task.wcet, task.source))
+
+    print("")
+    print("Kernel tick: {:.2f}us, scheduler overhead: {:.1f}us per pass".format(tick_period, overhead))
+    print("Total utilisation: {:.2f}%".format(100.0 * utilisation))
+
+    if schedulable:
+        print("The task set is schedulable.")
+    else:
+        print("The task set is NOT schedulable.")
+
+    return 0 if schedulable else 1
+
+
+# call main
+if __name__ == '__main__':
+    sys.exit(main())
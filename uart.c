@@ -32,13 +32,12 @@
 #include "driverlib/pin_map.h"
 #include "utils/ustdlib.h"
 
-#include "altitude.h"
+#include "aux_adc.h"
 #include "config.h"
 #include "flight_mode.h"
-#include "pwm.h"
 #include "setpoint.h"
 #include "uart.h"
-#include "yaw.h"
+#include "vehicle_state.h"
 
 /**
  * Define hardware settings for the UART
@@ -52,7 +51,7 @@ static const int UART_USB_GPIO_PIN_RX = GPIO_PIN_0;
 static const int UART_USB_GPIO_PIN_TX = GPIO_PIN_1;
 
 // buffer settings
-static const int UART_INPUT_BUFFER_SIZE = 40;
+static const int UART_INPUT_BUFFER_SIZE = 64;
 static char *g_buffer;
 
 void uart_init(void)
@@ -91,24 +90,41 @@ void uart_send(const char *t_buffer)
 
 void uart_flight_data_update(KernelTask* t_task)
 {
+    // take one copy of the state so every value sent is from the same
+    // update of its module
+    VehicleState state;
+    vehicle_state_get(&state);
+
     uint16_t target_yaw = setpoint_get_yaw();
-    uint16_t actual_yaw = yaw_get();
+    uint16_t actual_yaw = state.yaw;
 
     int16_t target_altitude = setpoint_get_altitude();
-    int16_t actual_altitude = alt_get();
-    uint8_t main_rotor_duty = pwm_get_main_duty();
-    uint8_t tail_rotor_duty = pwm_get_tail_duty();
+    int16_t actual_altitude = state.altitude;
+    int16_t altitude_rate = state.altitude_rate;
+    int16_t yaw_rate = state.yaw_rate;
+    // the degrees turned since the reference, counting whole turns
+    int32_t total_yaw = state.yaw_turns * 360 + state.yaw;
+    uint8_t main_rotor_duty = state.main_duty;
+    uint8_t tail_rotor_duty = state.tail_duty;
     uint8_t operating_mode = flight_mode_get();
 
     // format the outgoing data
 #if !CONFIG_DIRECT_CONTROL
-    usprintf(g_buffer, "Y%u\ty%u\tA%d\ta%d\tm%u\tt%u\to%u\r\n", target_yaw, actual_yaw, target_altitude, actual_altitude, main_rotor_duty, tail_rotor_duty, operating_mode);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "Y%u\ty%u\tA%d\ta%d\tm%u\tt%u\to%u\tr%d\tw%d\tn%d", target_yaw, actual_yaw, target_altitude, actual_altitude, main_rotor_duty, tail_rotor_duty, operating_mode, altitude_rate, yaw_rate, total_yaw);
 #else
-    usprintf(g_buffer, "y%u\ta%d\tm%u\tt%u\to%u\r\n", actual_yaw, actual_altitude, main_rotor_duty, tail_rotor_duty, operating_mode);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "y%u\ta%d\tm%u\tt%u\to%u\tr%d\tw%d\tn%d", actual_yaw, actual_altitude, main_rotor_duty, tail_rotor_duty, operating_mode, altitude_rate, yaw_rate, total_yaw);
 #endif
 
     // send it
     uart_send(g_buffer);
+
+#if ALT_ADC_AUX_CHANNELS
+    // the auxiliary channels go on the end so the tools still find the rest
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "\tv%u\ts%u", aux_get_supply_millivolts(), aux_get_spare());
+    uart_send(g_buffer);
+#endif
+
+    uart_send("\r\n");
 }
 
 
@@ -121,10 +137,57 @@ void uart_kernel_data_update(KernelTask* t_task)
     for (i = 0; i < num_tasks; i++)
     {
         KernelTask task = kernel_tasks[i];
-        usprintf(g_buffer, "%s,%u,%u,%u\t", task.name, task.duration_micros, task.period_micros, task.frequency);
+        usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "%s,%u,%u,%u\t", task.name, task.duration_micros, task.period_micros, task.frequency);
         uart_send(g_buffer);
 
     }
 
+    // the scheduler overhead is sent in the same format as a task so the
+    // tools can pick it out by name
+    uint32_t overhead_max;
+    uint32_t overhead = kernel_get_overhead_cycles(&overhead_max);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "kernel_overhead,%u,%u,%u\t", overhead, overhead_max, num_tasks);
+    uart_send(g_buffer);
+
+    // as is the worst pass, to see how well the task releases are spread out
+    uint8_t pass_tasks_max;
+    uint32_t pass_cycles_max = kernel_get_pass_peak(&pass_tasks_max);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "kernel_pass,%u,%u,%u\t", pass_cycles_max, pass_tasks_max, KERNEL_PHASE_OFFSETS);
+    uart_send(g_buffer);
+
+    // as is the share of time spent running passes, ticking and idle
+    uint16_t busy_permille;
+    uint16_t tick_permille;
+    uint16_t idle_permille;
+    kernel_get_load(&busy_permille, &tick_permille, &idle_permille);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "kernel_load,%u,%u,%u\t", busy_permille, idle_permille, KERNEL_TICKLESS);
+    uart_send(g_buffer);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "kernel_tick,%u,%u,%u\t", tick_permille, kernel_get_frequency() / 1000, KERNEL_TICKLESS);
+    uart_send(g_buffer);
+
+    // and how often it has had to shed tasks to recover from an overrun
+    uint32_t overruns;
+    uint32_t sheds = kernel_get_shed_count(&overruns);
+    usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "kernel_shed,%u,%u,%u\t", sheds, overruns, KERNEL_SHED_PRIORITY);
+    uart_send(g_buffer);
+
+    uart_send("\r\n");
+
+    // the tail latencies, overruns and sheds go on their own line so they
+    // don't upset the tools that parse the line above
+    uart_send("stats\t");
+    for (i = 0; i < num_tasks; i++)
+    {
+        const KernelTaskStats* stats = kernel_get_task_stats(i);
+        // a whole row can be longer than the buffer, so it is sent in two
+        usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "%s,%d,%d,", kernel_tasks[i].name,
+                  kernel_histogram_percentile(&stats->duration, 99), stats->duration.max);
+        uart_send(g_buffer);
+        usnprintf(g_buffer, UART_INPUT_BUFFER_SIZE, "%d,%d,%u,%u\t",
+                  kernel_histogram_percentile(&stats->jitter, 99), stats->jitter.max,
+                  kernel_tasks[i].overrun_count, kernel_tasks[i].shed_count);
+        uart_send(g_buffer);
+    }
+
     uart_send("\r\n");
 }
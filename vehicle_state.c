@@ -0,0 +1,137 @@
+/*******************************************************************************
+ *
+ * vehicle_state.c
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module holds the latest state of the helicopter, published by the
+ * modules that measure or set it. See vehicle_state.h.
+ *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "seqlock.h"
+#include "vehicle_state.h"
+#include "yaw.h"
+
+/**
+ * The yaw (in centidegrees) and whole turns, written by the yaw interrupts.
+ */
+static Seqlock g_yaw_lock;
+static volatile uint16_t g_yaw;
+static volatile int32_t g_yaw_turns;
+
+/**
+ * The rate of change of the yaw, written by yaw_update_rate.
+ */
+static Seqlock g_yaw_rate_lock;
+static volatile int16_t g_yaw_rate;
+
+/**
+ * The altitude and its rate of change, written by alt_update.
+ */
+static Seqlock g_altitude_lock;
+static volatile int16_t g_altitude;
+static volatile int16_t g_altitude_rate;
+
+/**
+ * The rotor duty cycles, written by the tasks that set them.
+ */
+static Seqlock g_duty_lock;
+static volatile int8_t g_main_duty;
+static volatile int8_t g_tail_duty;
+
+void vehicle_state_init(void)
+{
+    seqlock_init(&g_yaw_lock);
+    seqlock_init(&g_yaw_rate_lock);
+    seqlock_init(&g_altitude_lock);
+    seqlock_init(&g_duty_lock);
+
+    g_yaw = 0;
+    g_yaw_turns = 0;
+    g_yaw_rate = 0;
+    g_altitude = 0;
+    g_altitude_rate = 0;
+    g_main_duty = 0;
+    g_tail_duty = 0;
+}
+
+void vehicle_state_publish_yaw(uint16_t t_yaw_centidegrees, int32_t t_turns)
+{
+    seqlock_write_begin(&g_yaw_lock);
+    g_yaw = t_yaw_centidegrees;
+    g_yaw_turns = t_turns;
+    seqlock_write_end(&g_yaw_lock);
+}
+
+void vehicle_state_publish_yaw_rate(int16_t t_rate)
+{
+    seqlock_write_begin(&g_yaw_rate_lock);
+    g_yaw_rate = t_rate;
+    seqlock_write_end(&g_yaw_rate_lock);
+}
+
+void vehicle_state_publish_altitude(int16_t t_altitude, int16_t t_rate)
+{
+    seqlock_write_begin(&g_altitude_lock);
+    g_altitude = t_altitude;
+    g_altitude_rate = t_rate;
+    seqlock_write_end(&g_altitude_lock);
+}
+
+void vehicle_state_publish_duty(int8_t t_main_duty, int8_t t_tail_duty)
+{
+    seqlock_write_begin(&g_duty_lock);
+    g_main_duty = t_main_duty;
+    g_tail_duty = t_tail_duty;
+    seqlock_write_end(&g_duty_lock);
+}
+
+void vehicle_state_get(VehicleState* t_state)
+{
+    uint32_t sequence;
+
+    // a yaw edge can land part way through a copy, in which case it is
+    // simply copied again
+    do
+    {
+        sequence = seqlock_read_begin(&g_yaw_lock);
+        t_state->yaw_centidegrees = g_yaw;
+        t_state->yaw_turns = g_yaw_turns;
+    } while (seqlock_read_retry(&g_yaw_lock, sequence));
+    t_state->yaw = t_state->yaw_centidegrees / YAW_CENTIDEGREES_PER_DEGREE;
+    t_state->yaw_version = sequence / 2;
+
+    do
+    {
+        sequence = seqlock_read_begin(&g_yaw_rate_lock);
+        t_state->yaw_rate = g_yaw_rate;
+    } while (seqlock_read_retry(&g_yaw_rate_lock, sequence));
+    t_state->yaw_rate_version = sequence / 2;
+
+    do
+    {
+        sequence = seqlock_read_begin(&g_altitude_lock);
+        t_state->altitude = g_altitude;
+        t_state->altitude_rate = g_altitude_rate;
+    } while (seqlock_read_retry(&g_altitude_lock, sequence));
+    t_state->altitude_version = sequence / 2;
+
+    do
+    {
+        sequence = seqlock_read_begin(&g_duty_lock);
+        t_state->main_duty = g_main_duty;
+        t_state->tail_duty = g_tail_duty;
+    } while (seqlock_read_retry(&g_duty_lock, sequence));
+    t_state->duty_version = sequence / 2;
+}
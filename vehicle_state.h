@@ -0,0 +1,96 @@
+/*******************************************************************************
+ *
+ * vehicle_state.h
+ *
+ * ENEL361 Helicopter Project
+ * Friday Morning, Group 7
+ *
+ * Written by:
+ *  - Manu Hamblyn  <mfb31<@uclive.ac.nz>   95140875
+ *  - Will Cowper   <wgc22@uclive.ac.nz>    81163265
+ *  - Jesse Sheehan <jps111@uclive.ac.nz>   53366509
+ *
+ * Description:
+ * This module holds the latest state of the helicopter (the yaw, the
+ * altitude and the rotor duty cycles) for the tasks that display, send or act
+ * on it. Each producer publishes its part once per update, already converted,
+ * and a consumer copies the whole state in one call rather than calling each
+ * module's getters in turn.
+ *
+ * Each part has a sequence lock of its own, because the parts are written
+ * from different contexts (the yaw from its interrupts, the rest from tasks).
+ * A copy of a part is always from a single update, and the part's version
+ * says which update that was.
+ *
+ ******************************************************************************/
+
+#ifndef VEHICLE_STATE_H_
+#define VEHICLE_STATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * A copy of the helicopter's state.
+ */
+typedef struct {
+    // published by the yaw interrupts on every change, in centidegrees and
+    // in whole degrees, with the whole turns made since the reference
+    uint16_t yaw_centidegrees;
+    uint16_t yaw;
+    int32_t yaw_turns;
+    uint32_t yaw_version;
+
+    // published by yaw_update_rate
+    int16_t yaw_rate;
+    uint32_t yaw_rate_version;
+
+    // published by alt_update
+    int16_t altitude;
+    int16_t altitude_rate;
+    uint32_t altitude_version;
+
+    // published when either duty cycle is set
+    int8_t main_duty;
+    int8_t tail_duty;
+    uint32_t duty_version;
+} VehicleState;
+
+/**
+ * Initialises the state, with every value 0.
+ * This must be called before any of the modules that publish to it are
+ * initialised.
+ */
+void vehicle_state_init(void);
+
+/**
+ * Publishes the yaw (in centidegrees) and the number of whole turns made
+ * since the reference (clockwise positive, rounded down). This is only
+ * called by the yaw interrupts, which can't interrupt each other.
+ */
+void vehicle_state_publish_yaw(uint16_t t_yaw_centidegrees, int32_t t_turns);
+
+/**
+ * Publishes the rate that the yaw is changing at (in tenths of a degree per
+ * second, clockwise positive). This is only called by tasks.
+ */
+void vehicle_state_publish_yaw_rate(int16_t t_rate);
+
+/**
+ * Publishes the altitude (as a percentage) and its rate of change (in tenths
+ * of a percent per second). This is only called by tasks.
+ */
+void vehicle_state_publish_altitude(int16_t t_altitude, int16_t t_rate);
+
+/**
+ * Publishes the main and tail rotor duty cycles (as percentages). This is
+ * only called by tasks.
+ */
+void vehicle_state_publish_duty(int8_t t_main_duty, int8_t t_tail_duty);
+
+/**
+ * Copies the latest state into t_state. This can be called from any task.
+ */
+void vehicle_state_get(VehicleState* t_state);
+
+#endif /* VEHICLE_STATE_H_ */
@@ -16,12 +16,17 @@
  * This module contains functions required for calculating the slot
  *  count, yaw values, and initialising the quadrature state machine.
  * The states for the quadrature state machine are also defined.
- * A settling function is also provided in this module.
+ * A settling function is also provided in this module, as is an estimate
+ *  of the rate of turn from the times of the edges.
+ *
+ * With YAW_QEI set, the QEI peripheral counts the encoder edges instead of
+ * the quadrature state machine, and the position is read from it.
  * 
  ******************************************************************************/
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
@@ -30,17 +35,54 @@
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
 
-#include "circBufT.h"
+#include "config.h"
 #include "mutex.h"
+#include "seqlock.h"
+#include "settling.h"
 #include "utils.h"
+#include "vehicle_state.h"
 #include "yaw.h"
 
+#if YAW_QEI
+#include "inc/tm4c123gh6pm.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/qei.h"
+#endif
+
 /**
  * Defines the possible sates for the quadrature state machine.
  */
 enum quadrature_state { QUAD_STATE_CLOCKWISE, QUAD_STATE_ANTICLOCKWISE, QUAD_STATE_NOCHANGE, QUAD_STATE_INVALID };
 typedef enum quadrature_state QuadratureState;
 
+#if !YAW_QEI
+/**
+ * What a change from one state of the two signals to the next means: the
+ * change in the slot count and the new state of the FSM. A change of both
+ * signals at once is invalid, as the direction can't be known.
+ */
+typedef struct {
+    int8_t delta;
+    uint8_t state;
+} YawTransition;
+
+/**
+ * The transitions, indexed by (previous state << 2) | this state, where each
+ * state is (signal A << 1) | signal B. The signals go 0, 1, 3, 2 when turning
+ * clockwise.
+ */
+static const YawTransition YAW_TRANSITIONS[16] = {
+    // from 0
+    {  0, QUAD_STATE_NOCHANGE }, {  1, QUAD_STATE_CLOCKWISE }, { -1, QUAD_STATE_ANTICLOCKWISE }, {  0, QUAD_STATE_INVALID },
+    // from 1
+    { -1, QUAD_STATE_ANTICLOCKWISE }, {  0, QUAD_STATE_NOCHANGE }, {  0, QUAD_STATE_INVALID }, {  1, QUAD_STATE_CLOCKWISE },
+    // from 2
+    {  1, QUAD_STATE_CLOCKWISE }, {  0, QUAD_STATE_INVALID }, {  0, QUAD_STATE_NOCHANGE }, { -1, QUAD_STATE_ANTICLOCKWISE },
+    // from 3
+    {  0, QUAD_STATE_INVALID }, { -1, QUAD_STATE_ANTICLOCKWISE }, {  1, QUAD_STATE_CLOCKWISE }, {  0, QUAD_STATE_NOCHANGE },
+};
+#endif
+
 /**
  * For calculating the yaw in degrees.
  * 112 teeth over 4 phases gives 448
@@ -48,16 +90,78 @@ typedef enum quadrature_state QuadratureState;
 static const int YAW_MAX_SLOT_COUNT = 448;
 
 /**
- * The size of the settling buffer.
+ * The slot count is turned into an angle with a multiply and a shift rather
+ * than a divide. Each scale is the angle of one slot times 2^YAW_ANGLE_SHIFT,
+ * rounded up, which gives exactly the same angle as dividing for every slot
+ * count (0 - 447). They must be worked out again if YAW_MAX_SLOT_COUNT
+ * changes.
  */
-static const int YAW_SETTLING_BUF_SIZE = 10;
+#define YAW_ANGLE_SHIFT 16
+static const uint32_t YAW_DEGREES_SCALE = 52663;        // 360 * 2^16 / 448
+static const uint32_t YAW_CENTIDEGREES_SCALE = 5266286; // 36000 * 2^16 / 448
+
+/**
+ * The number of degree values in the settling window.
+ */
+#define YAW_SETTLING_BUF_SIZE 10
 
 /**
  * The maximum difference between the minimum and maximum values (in degrees)
- * of the settling buffer for the yaw_is_settled() to return true.
+ * of the settling window for the yaw_is_settled() to return true.
  */
 static const int YAW_SETTLING_MARGIN = 2;
 
+/**
+ * The rate of turn is estimated from the times of the edges, read from the
+ * kernel's free-running cycle clock. While turning slowly it is one tooth
+ * (YAW_RATE_PERIOD_EDGES edges in a row, so the spacing of the two channels
+ * doesn't matter) over the time between the edges at either end of it. Once
+ * YAW_RATE_COUNT_EDGES or more edges arrive between runs of yaw_update_rate,
+ * it is the edges counted over the time between the last edge seen by each
+ * run instead.
+ */
+#define YAW_RATE_PERIOD_EDGES 4
+static const int32_t YAW_RATE_COUNT_EDGES = 8;
+
+/**
+ * The rate is 0 once there hasn't been an edge for this long (in ms).
+ */
+static const uint32_t YAW_RATE_TIMEOUT_MS = 500;
+
+/**
+ * The edge times, written by the yaw interrupts: the number of edges counted
+ * (clockwise positive), the time of the last one, the number in a row in the
+ * same direction (up to 255) and the time taken by the last
+ * YAW_RATE_PERIOD_EDGES of those.
+ */
+static Seqlock g_edge_lock;
+static volatile int32_t g_edge_count;
+static volatile uint32_t g_edge_time;
+static volatile int8_t g_edge_direction;
+static volatile uint8_t g_edge_run;
+static volatile uint32_t g_edge_period;
+#if !YAW_QEI
+static uint32_t g_edge_times[YAW_RATE_PERIOD_EDGES];
+static uint8_t g_edge_index;
+#endif
+
+/**
+ * The state of the rate estimate, used by yaw_update_rate only. The edge
+ * count and time are from its previous run.
+ */
+static int32_t g_rate_edge_count;
+static uint32_t g_rate_edge_time;
+static bool g_rate_stopped;
+static int16_t g_rate;
+
+/**
+ * The number of tenths of a degree per second that one edge per clock cycle
+ * is, and YAW_RATE_TIMEOUT_MS in clock cycles.
+ */
+static uint32_t g_rate_scale;
+static uint32_t g_rate_timeout_cycles;
+
+#if !YAW_QEI
 /**
  * Holds the previous state of the Quadrature FSM
  */
@@ -67,21 +171,23 @@ static uint8_t g_previous_state;
  * Holds the current state of the Quadrature FSM
  */
 static volatile QuadratureState g_quadrature_state;
-
-/**
- * The mutex for the current quadrature state.
- */
-static Mutex g_quadrature_state_mutex;
+#endif
 
 /**
  * Holds the slot count (i.e. number of teeth moved from reference).
+ * With the QEI, this is the position last published.
  */
 static volatile uint16_t g_slot_count;
 
 /**
- * The mutex for the slot count.
+ * The number of slots turned since the reference was found (clockwise
+ * positive), which keeps counting past a full turn, and the number of whole
+ * turns in it (rounded down, so -1 is just anticlockwise of the reference).
+ * With the QEI, these are as of the last publish. They are only written by
+ * the yaw interrupts.
  */
-static Mutex g_slot_count_mutex;
+static volatile int32_t g_position;
+static volatile int32_t g_turns;
 
 /**
  * Indicates if the yaw has been calibrated.
@@ -94,10 +200,39 @@ static volatile bool g_has_been_calibrated;
 static Mutex g_has_been_calibrated_mutex;
 
 /**
- * The buffer that holds the degree values for settling calculations.
+ * The settling window over the last YAW_SETTLING_BUF_SIZE degree values.
  */
-static circBuf_t g_settling_buffer;
+static Settling g_settling;
+static SettlingEntry g_settling_entries[2 * YAW_SETTLING_BUF_SIZE];
 
+#if YAW_QEI
+/**
+ * Yaw Quadrature Encoder Interface:
+ * PD6 is the Phase A pin (PhA0)
+ * PD7 is the Phase B pin (PhB0), which is locked at reset
+ */
+static const uint32_t YAW_QEI_PERIPH = SYSCTL_PERIPH_QEI0;
+static const uint32_t YAW_QEI_BASE = QEI0_BASE;
+static const uint32_t YAW_QEI_PIN_PERIPH = SYSCTL_PERIPH_GPIOD;
+static const uint32_t YAW_QEI_PIN_BASE = GPIO_PORTD_BASE;
+static const uint32_t YAW_QEI_PIN_1 = GPIO_PIN_6;
+static const uint32_t YAW_QEI_PIN_2 = GPIO_PIN_7;
+static const uint32_t YAW_QEI_PIN_1_CONFIG = GPIO_PD6_PHA0;
+static const uint32_t YAW_QEI_PIN_2_CONFIG = GPIO_PD7_PHB0;
+static const int YAW_QEI_SIG_STRENGTH = GPIO_STRENGTH_4MA;
+static const int YAW_QEI_PIN_TYPE = GPIO_PIN_TYPE_STD_WPD;
+
+// count every edge of both phases (4 per tooth). the QEI counts up when
+// phase A leads, but channel B leads when turning clockwise, so the phases
+// are swapped.
+static const uint32_t YAW_QEI_CONFIG = QEI_CONFIG_CAPTURE_A_B | QEI_CONFIG_NO_RESET | QEI_CONFIG_QUADRATURE | QEI_CONFIG_SWAP;
+
+/**
+ * The number of times a second that the position is published to the
+ * vehicle state, from the QEI velocity timer interrupt.
+ */
+static const uint32_t YAW_QEI_PUBLISH_FREQUENCY = 200;
+#else
 /**
  * Yaw Quadrature Encoding:
  * PB0 is the Phase A pin
@@ -112,7 +247,7 @@ static const int YAW_QUAD_PIN_2 = GPIO_PIN_1;
 static const int YAW_QUAD_SIG_STRENGTH = GPIO_STRENGTH_4MA;
 static const int YAW_QUAD_PIN_TYPE = GPIO_PIN_TYPE_STD_WPD;
 static const int YAW_QUAD_EDGE_TYPE = GPIO_BOTH_EDGES;
-static const int YAW_QUAD_DDR = GPIO_DIR_MODE_IN;
+#endif
 
 /**
  * Yaw Reference:
@@ -123,31 +258,153 @@ static const int YAW_REF_BASE = GPIO_PORTC_BASE;
 static const int YAW_REF_INT_PIN = GPIO_INT_PIN_4;
 static const int YAW_REF_PIN = GPIO_PIN_4;
 static const int YAW_REF_SIG_STRENGTH = GPIO_STRENGTH_2MA;
+static const int YAW_REF_DDR = GPIO_DIR_MODE_IN;
 
 // specification conflict: pull up and rising edge are reliable
 static const int YAW_REF_PIN_TYPE = GPIO_PIN_TYPE_STD_WPU;
 static const int YAW_REF_EDGE_TYPE = GPIO_RISING_EDGE;
 
 // prototypes for functions local to the yaw module
+#if YAW_QEI
+void yaw_qei_int_handler(void);
+#else
 void yaw_update_state(bool t_signal_a, bool t_signal_b);
 void yaw_int_handler(void);
-void yaw_reference_int_handler(void);
 QuadratureState yaw_get_state(void);
+#endif
+void yaw_reference_int_handler(void);
 
 /**
- * Initialise yaw including:
- * state machine (previous and current states), calibration,
- * slot count, circular buffer for settling,
- * set up input pins, interrupts etc.
+ * Converts a slot count to degrees (0 - 359).
  */
-void yaw_init(void)
+static uint16_t yaw_slots_to_degrees(uint16_t t_slot_count)
+{
+    return ((uint32_t)t_slot_count * YAW_DEGREES_SCALE) >> YAW_ANGLE_SHIFT;
+}
+
+/**
+ * Converts a slot count to centidegrees (0 - 35919).
+ */
+static uint16_t yaw_slots_to_centidegrees(uint16_t t_slot_count)
+{
+    return ((uint32_t)t_slot_count * YAW_CENTIDEGREES_SCALE) >> YAW_ANGLE_SHIFT;
+}
+
+#if YAW_QEI
+/**
+ * Takes a difference in slot counts the shorter way round, giving a number
+ * of edges in the range -YAW_MAX_SLOT_COUNT / 2 to YAW_MAX_SLOT_COUNT / 2.
+ */
+static int32_t yaw_shorter_way(int32_t t_edges)
+{
+    if (t_edges > YAW_MAX_SLOT_COUNT / 2)
+    {
+        return t_edges - YAW_MAX_SLOT_COUNT;
+    }
+    if (t_edges < -YAW_MAX_SLOT_COUNT / 2)
+    {
+        return t_edges + YAW_MAX_SLOT_COUNT;
+    }
+    return t_edges;
+}
+#endif
+
+/**
+ * Converts some number of edges over a time (in clock cycles) to a rate of
+ * turn in tenths of a degree per second.
+ */
+static int16_t yaw_edges_to_rate(int32_t t_edges, uint32_t t_cycles)
+{
+    if (t_cycles == 0)
+    {
+        return 0;
+    }
+
+    int64_t rate = (int64_t)t_edges * g_rate_scale / t_cycles;
+    return clamp(rate, INT16_MIN, INT16_MAX);
+}
+
+/**
+ * Records t_edges edges (clockwise positive) at the time t_now. This is only
+ * called by the yaw interrupts, which can't interrupt each other.
+ */
+static void yaw_record_edges(int32_t t_edges, uint32_t t_now)
+{
+    int8_t direction = t_edges > 0 ? 1 : -1;
+
+    seqlock_write_begin(&g_edge_lock);
+
+    // a change of direction starts a new run
+    if (direction != g_edge_direction)
+    {
+        g_edge_direction = direction;
+        g_edge_run = 0;
+    }
+
+#if !YAW_QEI
+    // the oldest time is from YAW_RATE_PERIOD_EDGES edges ago. the QEI
+    // gives several edges at a time, so it never has a run and only counts
+    if (g_edge_run >= YAW_RATE_PERIOD_EDGES)
+    {
+        g_edge_period = t_now - g_edge_times[g_edge_index];
+    }
+    g_edge_times[g_edge_index] = t_now;
+    g_edge_index = (g_edge_index + 1) % YAW_RATE_PERIOD_EDGES;
+
+    if (g_edge_run < UINT8_MAX)
+    {
+        g_edge_run++;
+    }
+#endif
+    g_edge_count += t_edges;
+    g_edge_time = t_now;
+
+    seqlock_write_end(&g_edge_lock);
+}
+
+#if YAW_QEI
+/**
+ * Sets up the QEI to count the encoder, with the velocity timer interrupt
+ * publishing the position.
+ */
+static void yaw_qei_init(void)
+{
+    SysCtlPeripheralEnable(YAW_QEI_PIN_PERIPH);
+    SysCtlPeripheralEnable(YAW_QEI_PERIPH);
+
+    // PD7 is an NMI pin, which has to be unlocked before it can be changed
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_KEY;
+    GPIO_PORTD_CR_R |= YAW_QEI_PIN_2;
+    GPIO_PORTD_LOCK_R = GPIO_LOCK_M;
+
+    // give the pins to the QEI, with the same weak pull down as before
+    GPIOPinConfigure(YAW_QEI_PIN_1_CONFIG);
+    GPIOPinConfigure(YAW_QEI_PIN_2_CONFIG);
+    GPIOPinTypeQEI(YAW_QEI_PIN_BASE, YAW_QEI_PIN_1 | YAW_QEI_PIN_2);
+    GPIOPadConfigSet(YAW_QEI_PIN_BASE, YAW_QEI_PIN_1 | YAW_QEI_PIN_2, YAW_QEI_SIG_STRENGTH, YAW_QEI_PIN_TYPE);
+
+    // the position wraps around at a full turn
+    QEIDisable(YAW_QEI_BASE);
+    QEIConfigure(YAW_QEI_BASE, YAW_QEI_CONFIG, YAW_MAX_SLOT_COUNT - 1);
+    QEIPositionSet(YAW_QEI_BASE, 0);
+
+    // the velocity timer is only used for its interrupt
+    QEIVelocityConfigure(YAW_QEI_BASE, QEI_VELDIV_1, SysCtlClockGet() / YAW_QEI_PUBLISH_FREQUENCY);
+    QEIIntRegister(YAW_QEI_BASE, yaw_qei_int_handler);
+    QEIIntEnable(YAW_QEI_BASE, QEI_INTTIMER);
+
+    QEIVelocityEnable(YAW_QEI_BASE);
+    QEIEnable(YAW_QEI_BASE);
+}
+#else
+/**
+ * Sets up the pins to interrupt on every edge of either channel.
+ */
+static void yaw_quad_init(void)
 {
     g_previous_state = 0b00;
     g_quadrature_state = QUAD_STATE_NOCHANGE;
-    g_has_been_calibrated = false;
-    g_slot_count = 0;
-    initCircBuf(&g_settling_buffer, YAW_SETTLING_BUF_SIZE);
-    
+
     // setup the pins (PB0 is A, PB1 is B)
     SysCtlPeripheralEnable(YAW_QUAD_PERIPH);
 
@@ -169,7 +426,36 @@ void yaw_init(void)
     // Enable interrupts on GPIO Port B Pins 0,1 for Yaw channels A and B
     // (clears any outstanding interrupts)
     GPIOIntEnable(YAW_QUAD_BASE, YAW_QUAD_INT_PIN_1 | YAW_QUAD_INT_PIN_2);
+}
+#endif
 
+/**
+ * Initialise yaw including:
+ * state machine (previous and current states), calibration,
+ * slot count, settling window,
+ * set up input pins, interrupts etc.
+ */
+void yaw_init(void)
+{
+    g_has_been_calibrated = false;
+    g_slot_count = 0;
+    settling_init(&g_settling, g_settling_entries, YAW_SETTLING_BUF_SIZE, YAW_SETTLING_MARGIN);
+
+    seqlock_init(&g_edge_lock);
+    g_edge_count = 0;
+    g_edge_direction = 0;
+    g_edge_run = 0;
+    g_rate_edge_count = 0;
+    g_rate_stopped = true;
+    g_rate = 0;
+    g_rate_scale = (uint64_t)3600 * SysCtlClockGet() / YAW_MAX_SLOT_COUNT;
+    g_rate_timeout_cycles = SysCtlClockGet() / 1000 * YAW_RATE_TIMEOUT_MS;
+
+#if YAW_QEI
+    yaw_qei_init();
+#else
+    yaw_quad_init();
+#endif
 
     // enable the peripheral
     SysCtlPeripheralEnable(YAW_REF_PERIPH);
@@ -181,7 +467,7 @@ void yaw_init(void)
     GPIOPinTypeGPIOInput(YAW_REF_BASE, YAW_REF_PIN);
 
     // set data direction register as input mfb
-    GPIODirModeSet(YAW_REF_BASE, YAW_REF_PIN, YAW_QUAD_DDR);
+    GPIODirModeSet(YAW_REF_BASE, YAW_REF_PIN, YAW_REF_DDR);
 
     // configure it to be a weak pull up
     GPIOPadConfigSet(YAW_REF_BASE, YAW_REF_PIN, YAW_REF_SIG_STRENGTH, YAW_REF_PIN_TYPE);
@@ -207,76 +493,131 @@ void yaw_reference_int_handler(void)
     if (!g_has_been_calibrated)
     {
         mutex_lock(g_has_been_calibrated_mutex);
-        mutex_lock(g_slot_count_mutex);
 
+#if YAW_QEI
+        // the reference is the QEI's index
+        QEIPositionSet(YAW_QEI_BASE, 0);
+#else
+        // the edges aren't decoded until now, so start from where the
+        // encoder is rather than where it was when they stopped
+        g_previous_state = (GPIOPinRead(YAW_QUAD_BASE, YAW_QUAD_PIN_1) != 0) << 1
+                | (GPIOPinRead(YAW_QUAD_BASE, YAW_QUAD_PIN_2) != 0);
+#endif
         g_slot_count = 0;
+        g_position = 0;
+        g_turns = 0;
         g_has_been_calibrated = true;
+        vehicle_state_publish_yaw(0, 0);
 
-        mutex_unlock(g_slot_count_mutex);
         mutex_unlock(g_has_been_calibrated_mutex);
+
+        kernel_post_event(KERNEL_EVENT_YAW_REFERENCE);
     }
 
 }
 
+#if YAW_QEI
 /**
-* Updates the current state of the Quadrature FSM.
-* The general thinking is explained in the following document:
-* https://cdn.sparkfun.com/datasheets/Robotics/How%20to%20use%20a%20quadrature%20encoder.pdf
-*/
-void yaw_update_state(bool t_signal_a, bool t_signal_b)
+ * The interrupt handler for the QEI velocity timer. Publishes the position
+ * if it has moved since it was last published.
+ */
+void yaw_qei_int_handler(void)
 {
-    mutex_lock(g_slot_count_mutex);
-    mutex_lock(g_quadrature_state_mutex);
+    QEIIntClear(YAW_QEI_BASE, QEI_INTTIMER);
 
-    // compare with previous state
-    uint8_t this_state = (t_signal_a << 1) | t_signal_b;
-
-    // update g_quadrature_state depending on the previous state
-    if (this_state == g_previous_state) {
-        g_quadrature_state = QUAD_STATE_NOCHANGE;
-    } else {
-        if (
-                (this_state == 0 && g_previous_state == 1) ||
-                (this_state == 1 && g_previous_state == 3) ||
-                (this_state == 2 && g_previous_state == 0) ||
-                (this_state == 3 && g_previous_state == 2)) {
-
-            g_quadrature_state = QUAD_STATE_ANTICLOCKWISE;
-
-            if (--g_slot_count > YAW_MAX_SLOT_COUNT - 1) {
-                g_slot_count = YAW_MAX_SLOT_COUNT - 1;
+    if (g_has_been_calibrated)
+    {
+        uint16_t slot_count = QEIPositionGet(YAW_QEI_BASE);
+        if (slot_count != g_slot_count)
+        {
+            // the QEI doesn't give the edge times, so the edges are counted
+            // at the time of this interrupt, taking the shorter way round
+            int32_t edges = yaw_shorter_way((int32_t)slot_count - g_slot_count);
+            yaw_record_edges(edges, kernel_get_cycle_count());
+
+            // the QEI wrapped through 0 if it went the other way to the edges
+            g_position += edges;
+            if (edges > 0 && slot_count < g_slot_count)
+            {
+                g_turns++;
+            }
+            else if (edges < 0 && slot_count > g_slot_count)
+            {
+                g_turns--;
             }
 
-        } else {
-            if (
-                    (this_state == 0 && g_previous_state == 2) ||
-                    (this_state == 1 && g_previous_state == 0) ||
-                    (this_state == 2 && g_previous_state == 3) ||
-                    (this_state == 3 && g_previous_state == 1)) {
+            g_slot_count = slot_count;
+            vehicle_state_publish_yaw(yaw_slots_to_centidegrees(slot_count), g_turns);
 
-                g_quadrature_state = QUAD_STATE_CLOCKWISE;
+            kernel_post_event(KERNEL_EVENT_YAW_EDGE);
+        }
+    }
+}
 
-                if (++g_slot_count > YAW_MAX_SLOT_COUNT - 1) {
-                    g_slot_count = 0;
-                }
-            } else {
-                g_quadrature_state = QUAD_STATE_INVALID;
-            }
+/**
+ * Returns the slot count, read from the QEI once the reference has been
+ * found.
+ */
+static uint16_t yaw_get_slot_count(void)
+{
+    if (g_has_been_calibrated)
+    {
+        return QEIPositionGet(YAW_QEI_BASE);
+    }
+    return g_slot_count;
+}
+
+int32_t yaw_get_position(void)
+{
+    // read once, as the QEI interrupt can change it
+    int32_t position = g_position;
+    if (g_has_been_calibrated)
+    {
+        // add the edges that the QEI has counted since it was last published
+        int32_t published = position % YAW_MAX_SLOT_COUNT;
+        if (published < 0)
+        {
+            published += YAW_MAX_SLOT_COUNT;
         }
+        position += yaw_shorter_way((int32_t)QEIPositionGet(YAW_QEI_BASE) - published);
     }
+    return position;
+}
+#else
+/**
+* Updates the current state of the Quadrature FSM.
+* The general thinking is explained in the following document:
+* https://cdn.sparkfun.com/datasheets/Robotics/How%20to%20use%20a%20quadrature%20encoder.pdf
+*/
+void yaw_update_state(bool t_signal_a, bool t_signal_b)
+{
+    uint8_t this_state = (t_signal_a << 1) | t_signal_b;
+    YawTransition transition = YAW_TRANSITIONS[(g_previous_state << 2) | this_state];
 
-    // update g_previous_raw_quadrature_state to this state
+    g_quadrature_state = transition.state;
     g_previous_state = this_state;
 
-    mutex_unlock(g_quadrature_state_mutex);
-    mutex_unlock(g_slot_count_mutex);
-}
+    if (transition.delta != 0)
+    {
+        // move the slot count, wrapping around at a full turn
+        int16_t slot_count = (int16_t)g_slot_count + transition.delta;
+        if (slot_count < 0)
+        {
+            slot_count += YAW_MAX_SLOT_COUNT;
+            g_turns--;
+        }
+        else if (slot_count >= YAW_MAX_SLOT_COUNT)
+        {
+            slot_count -= YAW_MAX_SLOT_COUNT;
+            g_turns++;
+        }
+        g_slot_count = slot_count;
+        g_position += transition.delta;
+        yaw_record_edges(transition.delta, kernel_get_cycle_count());
 
-void yaw_update_settling(KernelTask* t_task)
-{
-    // we add 180 degrees because we only care about the settling
-    // around 0 degrees and because of underflows this is difficult
-    writeCircBuf(&g_settling_buffer, yaw_get() + 180);
+        // publish the new yaw, converted once here rather than by every reader
+        vehicle_state_publish_yaw(yaw_slots_to_centidegrees(g_slot_count), g_turns);
+    }
 }
 
 /**
@@ -284,20 +625,12 @@ void yaw_update_settling(KernelTask* t_task)
 */
 QuadratureState yaw_get_state(void)
 {
-    mutex_wait(g_quadrature_state_mutex);
     QuadratureState temp_state = g_quadrature_state;
-
-    mutex_wait(g_quadrature_state_mutex);
     g_quadrature_state = QUAD_STATE_NOCHANGE;
 
     return temp_state;
 }
 
-uint16_t yaw_get(void)
-{
-    return g_slot_count * 360.0f / YAW_MAX_SLOT_COUNT;
-}
-
 /**
  * The interrupt handler for the for Quadrature interrupt.
  */
@@ -316,9 +649,119 @@ void yaw_int_handler(void)
 
         // update the quadrature stuff
         yaw_update_state(signal_a, signal_b);
+
+        kernel_post_event(KERNEL_EVENT_YAW_EDGE);
     }
 }
 
+/**
+ * Returns the slot count.
+ */
+static uint16_t yaw_get_slot_count(void)
+{
+    return g_slot_count;
+}
+
+int32_t yaw_get_position(void)
+{
+    return g_position;
+}
+#endif
+
+void yaw_update_settling(KernelTask* t_task)
+{
+    settling_add(&g_settling, yaw_get());
+}
+
+uint16_t yaw_get(void)
+{
+    return yaw_slots_to_degrees(yaw_get_slot_count());
+}
+
+uint16_t yaw_get_centidegrees(void)
+{
+    return yaw_slots_to_centidegrees(yaw_get_slot_count());
+}
+
+int32_t yaw_get_turns(void)
+{
+    int32_t position = yaw_get_position();
+
+    // round down rather than towards 0
+    if (position < 0)
+    {
+        position -= YAW_MAX_SLOT_COUNT - 1;
+    }
+    return position / YAW_MAX_SLOT_COUNT;
+}
+
+void yaw_update_rate(KernelTask* t_task)
+{
+    int32_t edge_count;
+    uint32_t edge_time;
+    int8_t edge_direction;
+    uint8_t edge_run;
+    uint32_t edge_period;
+    uint32_t sequence;
+
+    do
+    {
+        sequence = seqlock_read_begin(&g_edge_lock);
+        edge_count = g_edge_count;
+        edge_time = g_edge_time;
+        edge_direction = g_edge_direction;
+        edge_run = g_edge_run;
+        edge_period = g_edge_period;
+    } while (seqlock_read_retry(&g_edge_lock, sequence));
+
+    int32_t edges = edge_count - g_rate_edge_count;
+    uint32_t since = kernel_get_cycle_count() - edge_time;
+
+    if (edges == 0)
+    {
+        // nothing has moved, so the rate can be no more than one edge in the
+        // time since the last one
+        if (g_rate_stopped || since > g_rate_timeout_cycles)
+        {
+            g_rate_stopped = true;
+            g_rate = 0;
+        }
+        else
+        {
+            int16_t limit = yaw_edges_to_rate(1, since);
+            g_rate = clamp(g_rate, -limit, limit);
+        }
+    }
+    else if (abs(edges) < YAW_RATE_COUNT_EDGES && edge_run > YAW_RATE_PERIOD_EDGES)
+    {
+        // slow: the time of the last tooth
+        g_rate = yaw_edges_to_rate(edge_direction * YAW_RATE_PERIOD_EDGES, edge_period);
+        g_rate_stopped = false;
+    }
+    else if (g_rate_stopped)
+    {
+        // just started moving, so there's no edge time from the last run to
+        // count from
+        g_rate = 0;
+        g_rate_stopped = false;
+    }
+    else
+    {
+        // fast: the edges counted since the last run
+        g_rate = yaw_edges_to_rate(edges, edge_time - g_rate_edge_time);
+    }
+
+    g_rate_edge_count = edge_count;
+    g_rate_edge_time = edge_time;
+
+    vehicle_state_publish_yaw_rate(g_rate);
+}
+
+int16_t yaw_get_rate(void)
+{
+    return g_rate;
+}
+
 void yaw_reset_calibration_state(void)
 {
     mutex_wait(g_has_been_calibrated_mutex);
@@ -333,26 +776,19 @@ bool yaw_has_been_calibrated(void)
 
 bool yaw_is_settled(void)
 {
-    return getRangeCircBuf(&g_settling_buffer) <= YAW_SETTLING_MARGIN * 2;
+    return settling_is_settled(&g_settling);
 }
 
 int32_t yaw_get_settled(void)
 {
     if (yaw_is_settled()) {
-        return (getSmallestCircBuf(&g_settling_buffer) + YAW_SETTLING_MARGIN - 180);
+        return settling_get_settled(&g_settling);
     }
     return -1;
 }
 
 bool yaw_is_settled_around(int32_t t_value)
 {
-    if (yaw_is_settled())
-    {
-        return range(180 + yaw_get_settled(), 180 + t_value - YAW_SETTLING_MARGIN, 180 + t_value + YAW_SETTLING_MARGIN);
-    }
-    else
-    {
-        return false;
-    }
+    return settling_is_settled_around(&g_settling, t_value);
 }
 
@@ -27,6 +27,11 @@
 
 #include "kernel.h"
 
+/**
+ * The number of centidegrees (the unit of yaw_get_centidegrees) in a degree.
+ */
+#define YAW_CENTIDEGREES_PER_DEGREE 100
+
 /**
  * Initialises the quadrature module.
  * This must be called before any other functions in the quadrature module.
@@ -39,6 +44,40 @@ void yaw_init(void);
  */
 uint16_t yaw_get(void);
 
+/**
+ * Returns the current yaw value in hundredths of a degree.
+ * This is a bearing in the range 0 - 35919 (the slot before 0 is 359.19
+ * degrees).
+ */
+uint16_t yaw_get_centidegrees(void);
+
+/**
+ * Returns the number of slots (448 to a turn) that the helicopter has turned
+ * since the reference was found, clockwise positive. Unlike the bearing, this
+ * keeps counting past a full turn.
+ */
+int32_t yaw_get_position(void);
+
+/**
+ * Returns the number of whole turns that the helicopter has made since the
+ * reference was found, clockwise positive. This is rounded down, so it is -1
+ * just anticlockwise of the reference.
+ */
+int32_t yaw_get_turns(void);
+
+/**
+ * Kernel Task
+ * Estimates the rate of turn from the times of the edges since the last run,
+ * and publishes it to the vehicle state.
+ */
+void yaw_update_rate(KernelTask* t_task);
+
+/**
+ * Returns the rate of turn in tenths of a degree per second (clockwise
+ * positive), as of the last run of yaw_update_rate.
+ */
+int16_t yaw_get_rate(void);
+
 /**
  * Sets the calibration state to false.
  */